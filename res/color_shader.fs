@@ -0,0 +1,150 @@
+#version 450
+
+// written by TilePyramid::set_view_parameters() and JuliaPreview, same layout in every shader using it
+layout(std140, binding = 0) uniform view
+{
+    vec2 area_w;
+    vec2 area_h;
+    vec2 target_size;
+    uint max_iterations;
+    bool heatmap;
+    bool collect_statistics;
+    bool equalize;
+    bool distance_estimation;
+    dvec2 precise_area_w;
+    dvec2 precise_area_h;
+    dvec2 julia_parameter;      // C of the JULIA permutation
+};
+
+layout(binding = 0) uniform usampler2D iterations;
+
+// Pixel counts fit into 32 bits, iteration sums do not: a bucket of about 1900 pixels at up to
+// 2^22 iterations each wraps past 2^32, so those are kept as two words, see add_carry().
+struct Counters
+{
+    uint iterations_low;
+    uint iterations_high;
+    uint pixels;
+    uint max_pixels;
+    uint skipped_pixels;
+    uint interior_pixels;
+    uint saved_iterations_low;  // max_iterations less the count of interior pixels
+    uint saved_iterations_high;
+};
+
+// buckets by pixel position keep contention and per-counter totals low
+layout(std430, binding = 0) buffer statistics
+{
+    Counters buckets[256];
+};
+
+// histogram equalization, see HistogramEqualizer
+const uint BIN_COUNT = 1024u;
+const uint LOCAL_HISTOGRAMS = 16u;
+
+layout(std430, binding = 1) buffer histograms
+{
+    uint counts[LOCAL_HISTOGRAMS * BIN_COUNT];
+};
+
+// written by equalize_shader.comp from the previous frame's counts
+layout(std430, binding = 2) readonly buffer cdf
+{
+    float cumulative[BIN_COUNT];
+};
+
+const uint SKIPPED = 0x80000000u;
+const uint INTERIOR = 0x40000000u;
+const uint FLAGS = SKIPPED | INTERIOR;
+// fraction bits of the smooth count below the iteration count, see mandelbrot_shader.fs
+const uint FRACTION_BITS = 8u;
+// with distance_estimation the fraction bits hold the distance to the boundary instead, in 64ths
+// of a pixel, see mandelbrot_shader.fs
+const float CODES_PER_PIXEL = 64.0;
+
+in vec2 texture_position;
+
+out vec4 pixel_color;
+
+// smooth count times PALETTE_CYCLES / max_iterations (or its equalized share), repeating; linear
+// filtering blends the colors
+layout(binding = 1) uniform sampler1D palette;
+
+// as many cycles over the iteration range as the old banded color map had
+const float PALETTE_CYCLES = 100.0 / 17.0;
+
+// Whether adding value to a word that held previous wrapped it; atomicAdd() returns previous, so
+// exactly the add that wraps carries into the high word.
+bool add_carry(const uint previous, const uint value)
+{
+    return previous + value < previous;
+}
+
+// black through red and yellow to white with rising cost
+vec3 heat(const float cost)
+{
+    return clamp(vec3(3.0 * cost, 3.0 * cost - 1.0, 3.0 * cost - 2.0), 0.0, 1.0);
+}
+
+void main()
+{
+    const uint value = texture(iterations, texture_position).r;
+    const uint iteration = (value & ~FLAGS) >> FRACTION_BITS;
+    const uint fraction = value & ((1u << FRACTION_BITS) - 1u);
+    const float smooth_iteration = distance_estimation ? float(iteration) : float(value & ~FLAGS) / float(1u << FRACTION_BITS);
+    const bool skipped = (value & SKIPPED) != 0u;
+    const bool interior = (value & INTERIOR) != 0u;
+
+    if (collect_statistics)
+    {
+        const uint bucket = (uint(gl_FragCoord.x) & 15u) | (uint(gl_FragCoord.y) & 15u) << 4;
+
+        const uint cost = skipped ? 0u : iteration;
+        if (add_carry(atomicAdd(buckets[bucket].iterations_low, cost), cost))
+            atomicAdd(buckets[bucket].iterations_high, 1u);
+        atomicAdd(buckets[bucket].pixels, 1u);
+        if (iteration == max_iterations)
+            atomicAdd(buckets[bucket].max_pixels, 1u);
+        if (skipped)
+            atomicAdd(buckets[bucket].skipped_pixels, 1u);
+        if (interior)
+        {
+            atomicAdd(buckets[bucket].interior_pixels, 1u);
+            const uint saved = max_iterations - min(iteration, max_iterations);
+            if (add_carry(atomicAdd(buckets[bucket].saved_iterations_low, saved), saved))
+                atomicAdd(buckets[bucket].saved_iterations_high, 1u);
+        }
+    }
+
+    if (heatmap)
+    {
+        pixel_color = vec4(skipped ? vec3(0.0, 0.25, 0.1) : heat(float(iteration) / float(max(max_iterations, 1u))), 1.0);
+        return;
+    }
+
+    if (interior || iteration >= max_iterations)
+    {
+        pixel_color = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+
+    float coordinate = smooth_iteration / float(max_iterations);
+    if (equalize)
+    {
+        const float position = coordinate * float(BIN_COUNT);
+        const uint bin = min(uint(position), BIN_COUNT - 1u);
+        const uint histogram = (uint(gl_FragCoord.x) & 3u) | (uint(gl_FragCoord.y) & 3u) << 2;
+
+        atomicAdd(counts[histogram * BIN_COUNT + bin], 1u);
+
+        // linear within the bin, so the smooth count stays smooth
+        coordinate = mix(bin > 0u ? cumulative[bin - 1u] : 0.0, cumulative[bin], position - float(bin));
+    }
+
+    vec3 color = texture(palette, coordinate * PALETTE_CYCLES).rgb;
+    // filaments darken where they come within a pixel
+    if (distance_estimation)
+        color *= smoothstep(0.0, 1.0, float(fraction) / CODES_PER_PIXEL);
+
+    pixel_color = vec4(color, 1.0);
+}
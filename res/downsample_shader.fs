@@ -0,0 +1,15 @@
+#version 450
+
+layout(binding = 0) uniform usampler2D child;
+
+in vec2 texture_position;
+
+layout(location = 0) out uint iteration_output;
+
+void main()
+{
+    const ivec2 base = ivec2(texture_position * vec2(textureSize(child, 0))) & ~1;
+
+    iteration_output = max(max(texelFetch(child, base, 0).r,              texelFetch(child, base + ivec2(1, 0), 0).r),
+                           max(texelFetch(child, base + ivec2(0, 1), 0).r, texelFetch(child, base + ivec2(1, 1), 0).r));
+}
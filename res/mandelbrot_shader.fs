@@ -1,54 +1,258 @@
 #version 450
 
-layout(location = 0) uniform float rect_width;
-layout(location = 1) uniform float rect_height;
-layout(location = 2) uniform vec2 area_w;
-layout(location = 3) uniform vec2 area_h;
-layout(location = 4) uniform uint max_iterations;
-
-out vec4 pixel_color;
-
-const vec3 color_map[] = {
-    {0.0,  0.0,  0.0},
-    {0.26, 0.18, 0.06},
-    {0.1,  0.03, 0.1},
-    {0.04, 0.0,  0.18},
-    {0.02, 0.02, 0.29},
-    {0.0,  0.03, 0.39},
-    {0.05, 0.17, 0.54},
-    {0.09, 0.32, 0.69},
-    {0.22, 0.49, 0.82},
-    {0.52, 0.71, 0.9},
-    {0.82, 0.92, 0.97},
-    {0.94, 0.91, 0.75},
-    {0.97, 0.79, 0.37},
-    {1.0,  0.67, 0.0},
-    {0.8,  0.5,  0.0},
-    {0.6,  0.34, 0.0},
-    {0.41, 0.2,  0.01}
+// Permutations, see iteration_files() in main.cpp:
+//   DOUBLE_PRECISION     iterates in doubles, from the precise_ copy of the area
+//   DISTANCE_ESTIMATION  carries dZ/dC and stores the exterior distance estimate in place of the
+//                        smooth fraction
+//   INTERIOR_DETECTION   carries dZ/dZ0 and stops orbits caught by an attracting cycle
+//   JULIA                iterates from the pixel as Z0 with julia_parameter as C, see JuliaPreview
+// and at most one formula, z^2 + c without:
+//   MULTIBROT_POWER n    z^n + c
+//   BURNING_SHIP         (|Re z| + i |Im z|)^2 + c
+//   TRICORN              conj(z)^2 + c
+// The derivatives exist for the holomorphic formulas only; main.cpp never combines them with the
+// other two.
+
+// written by TilePyramid::set_view_parameters() and JuliaPreview, same layout in every shader using it
+layout(std140, binding = 0) uniform view
+{
+    vec2 area_w;
+    vec2 area_h;
+    vec2 target_size;
+    uint max_iterations;
+    bool heatmap;
+    bool collect_statistics;
+    bool equalize;
+    bool distance_estimation;
+    dvec2 precise_area_w;
+    dvec2 precise_area_h;
+    dvec2 julia_parameter;      // C of the JULIA permutation
 };
 
-void main()
+#ifdef DOUBLE_PRECISION
+#define real   double
+#define real2  dvec2
+#define AREA_W precise_area_w
+#define AREA_H precise_area_h
+#else
+#define real   float
+#define real2  vec2
+#define AREA_W area_w
+#define AREA_H area_h
+#endif
+
+#ifdef JULIA
+// dZ/dZ0 starts out as 1 and gains nothing from C
+#define DERIVATIVE_START real2(1.0, 0.0)
+#define DERIVATIVE_STEP  real2(0.0)
+#else
+// dZ/dC starts out as 0 and gains 1 from C each step
+#define DERIVATIVE_START real2(0.0)
+#define DERIVATIVE_STEP  real2(1.0, 0.0)
+#endif
+
+#ifdef MULTIBROT_POWER
+#define DEGREE MULTIBROT_POWER
+#else
+#define DEGREE 2
+#endif
+
+layout(location = 0) out uint iteration_output;
+
+// set on pixels resolved without iterating
+const uint SKIPPED = 0x80000000u;
+// set on pixels found interior before max_iterations; their count is the iterations spent
+const uint INTERIOR = 0x40000000u;
+// the iteration count sits between the flags and the fraction of the smooth count, so
+// max_iterations < 2^22
+const uint FRACTION_BITS = 8u;
+// far beyond 2, so that log log |Z| varies smoothly across iteration bands
+const float ESCAPE_RADIUS = 256.0;
+
+real2 pixel_point(const vec2 position)
+{
+    return real2(real(position.x) * (AREA_W.y - AREA_W.x) / real(target_size.x) + AREA_W.x,
+                 real(position.y) * (AREA_H.y - AREA_H.x) / real(target_size.y) + AREA_H.x);
+}
+
+real2 complex_multiply(const real2 a, const real2 b)
+{
+    return real2(a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x);
+}
+
+real2 formula(const real2 Z, const real2 C)
 {
-    const vec2 C = vec2(gl_FragCoord.x * (area_w.y - area_w.x) / rect_width  + area_w.x,
-                        gl_FragCoord.y * (area_h.y - area_h.x) / rect_height + area_h.x);
-    vec2 Z = vec2(0.0);
+#if defined(MULTIBROT_POWER)
+    real2 power = Z;
+    for (int i = 1; i < MULTIBROT_POWER; ++i)
+        power = complex_multiply(power, Z);
+    return power + C;
+#elif defined(BURNING_SHIP)
+    const real2 A = abs(Z);
+    return real2(A.x * A.x - A.y * A.y, 2.0 * A.x * A.y) + C;
+#elif defined(TRICORN)
+    return real2(Z.x * Z.x - Z.y * Z.y, -2.0 * Z.x * Z.y) + C;
+#else
+    return real2(Z.x * Z.x - Z.y * Z.y, 2.0 * Z.x * Z.y) + C;
+#endif
+}
+
+// d formula / dZ of the holomorphic formulas: DEGREE Z^(DEGREE - 1)
+real2 formula_derivative(const real2 Z)
+{
+    real2 power = real2(1.0, 0.0);
+    for (int i = 1; i < DEGREE; ++i)
+        power = complex_multiply(power, Z);
+    return real(DEGREE) * power;
+}
+
+// Points inside the main cardioid or the period-2 bulb of z^2 + c never escape.
+bool inside_known_component(const real2 C)
+{
+#if defined(MULTIBROT_POWER) || defined(BURNING_SHIP) || defined(TRICORN)
+    return false;
+#else
+    const real q = (C.x - 0.25) * (C.x - 0.25) + C.y * C.y;
+
+    return q * (q + (C.x - 0.25)) <= 0.25 * C.y * C.y ||
+           (C.x + 1.0) * (C.x + 1.0) + C.y * C.y <= 0.0625;
+#endif
+}
+
+#ifdef INTERIOR_DETECTION
+// |dZ/dZ0|^2 below which the orbit is taken to have fallen into an attracting cycle; small enough
+// that escaping orbits lingering near one are not mistaken for it
+const float INTERIOR_THRESHOLD = 1e-12;
+#endif
+
+// Returns the iteration count at which the orbit of Z0 escaped, max_iterations if it did not.
+// fraction is the smooth part of the count; distance the exterior distance estimate
+// |Z| log |Z| / |dZ|, dZ the derivative by the pixel, in the units of the pixel's point, or 0
+// without DISTANCE_ESTIMATION or escape. interior is set if INTERIOR_DETECTION stopped the orbit
+// early; the count is then the iterations spent.
+uint iterate(const real2 Z0, const real2 C, out float fraction, out float distance, out bool interior)
+{
+    real2 Z = Z0;
+#ifdef DISTANCE_ESTIMATION
+    real2 dZ = DERIVATIVE_START;
+#endif
+#ifdef INTERIOR_DETECTION
+    // from Z1 on, the Mandelbrot Z0 = 0 would zero it
+    real2 dZ0 = real2(1.0, 0.0);
+#endif
     uint iteration = 0;
+    fraction = 0.0;
+    distance = 0.0;
+    interior = false;
 
     while (iteration < max_iterations)
     {
-        const float x = Z.x * Z.x - Z.y * Z.y + C.x;
-        const float y = 2.0 * Z.x * Z.y       + C.y;
+#ifdef DISTANCE_ESTIMATION
+        dZ = complex_multiply(formula_derivative(Z), dZ) + DERIVATIVE_STEP;
+#endif
+        const real2 next = formula(Z, C);
 
-        if (x * x + y * y > 4.0)
+        const real magnitude = dot(next, next);
+        if (magnitude > ESCAPE_RADIUS * ESCAPE_RADIUS)
+        {
+            // |Z| lies between R and about R^DEGREE here, so this falls in [0, 1)
+            fraction = 1.0 - log2(0.5 * log(float(magnitude)) / log(ESCAPE_RADIUS)) / log2(float(DEGREE));
+#ifdef DISTANCE_ESTIMATION
+            // the ratio first: dZ can outgrow what a float holds long before Z escapes
+            distance = float(sqrt(magnitude / dot(dZ, dZ))) * 0.5 * log(float(magnitude));
+#endif
             break;
+        }
 
-        Z.x = x;
-        Z.y = y;
+        Z = next;
 
         ++iteration;
+
+#ifdef INTERIOR_DETECTION
+        // the multiplier of an attracting cycle shrinks it towards 0, escaping orbits make it grow
+        dZ0 = complex_multiply(formula_derivative(Z), dZ0);
+        if (dot(dZ0, dZ0) < INTERIOR_THRESHOLD)
+        {
+            interior = true;
+            break;
+        }
+#endif
+    }
+
+    return iteration;
+}
+
+// The pixel's point is C, or with JULIA the start of the orbit.
+uint iterate_pixel(const vec2 position, out float fraction, out float distance, out bool interior)
+{
+#ifdef JULIA
+    return iterate(pixel_point(position), real2(julia_parameter), fraction, distance, interior);
+#else
+    return iterate(real2(0.0), pixel_point(position), fraction, distance, interior);
+#endif
+}
+
+#ifdef DISTANCE_ESTIMATION
+// distance codes per pixel, so the 8 fraction bits cover up to 4 pixels from the boundary
+const float CODES_PER_PIXEL = 64.0;
+const float DISTANCE_LIMIT = 255.0 / CODES_PER_PIXEL;
+
+float pixel_distance(const float distance, const float pixel_size)
+{
+    return distance > 0.0 ? min(distance / pixel_size, DISTANCE_LIMIT) : 0.0;
+}
+
+// Within a pixel of the boundary the estimate is averaged with four more samples a quarter pixel
+// off, so that filaments shade by how much of the pixel they cross; everywhere else one sample is
+// enough. Pixels that never escape have distance 0 and are not supersampled: the INTERIOR test
+// misses minibrots and most bulbs, where every extra sample would run all max_iterations.
+uint distance_code(const float distance)
+{
+    const float pixel_size = float((AREA_W.y - AREA_W.x) / real(target_size.x));
+
+    float pixels = pixel_distance(distance, pixel_size);
+    if (distance > 0.0 && pixels < 1.0)
+    {
+        for (uint i = 0u; i < 4u; ++i)
+        {
+            const vec2 offset = vec2(float(i & 1u), float(i >> 1)) * 0.5 - 0.25;
+
+            float sample_fraction, sample_distance;
+            bool sample_interior;
+            iterate_pixel(gl_FragCoord.xy + offset, sample_fraction, sample_distance, sample_interior);
+            pixels += pixel_distance(sample_distance, pixel_size);
+        }
+        pixels /= 5.0;
+    }
+
+    return min(uint(pixels * CODES_PER_PIXEL), 255u);
+}
+#endif
+
+void main()
+{
+#ifndef JULIA
+    if (inside_known_component(pixel_point(gl_FragCoord.xy)))
+    {
+        iteration_output = max_iterations << FRACTION_BITS | SKIPPED;
+        return;
+    }
+#endif
+
+    float fraction, distance;
+    bool interior;
+    const uint iteration = iterate_pixel(gl_FragCoord.xy, fraction, distance, interior);
+
+    if (interior)
+    {
+        iteration_output = iteration << FRACTION_BITS | INTERIOR;
+        return;
     }
 
-    const uint row_index = (iteration * 100 / max_iterations % 17);
-    pixel_color = vec4((iteration == max_iterations ? vec3(0.0) : color_map[row_index]), 1.0);
+#ifdef DISTANCE_ESTIMATION
+    iteration_output = iteration << FRACTION_BITS | distance_code(distance);
+#else
+    const uint fraction_mask = (1u << FRACTION_BITS) - 1u;
+    iteration_output = iteration << FRACTION_BITS | min(uint(clamp(fraction, 0.0, 1.0) * float(fraction_mask + 1u)), fraction_mask);
+#endif
 }
@@ -1,8 +1,8 @@
 #version 450 core
 
-layout(location = 0) in vec3 vertex_position;
-
+// One triangle covering the whole target, (-1, -1), (3, -1) and (-1, 3), without a vertex buffer:
+// unlike two triangles it has no diagonal along which fragments are shaded twice.
 void main()
 {
-    gl_Position = vec4(vertex_position, 1.0);
+    gl_Position = vec4(vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0, 0.0, 1.0);
 }
@@ -0,0 +1,15 @@
+#version 450 core
+
+layout(location = 5) uniform vec4 screen_rect;
+layout(location = 6) uniform vec4 texture_rect;
+
+out vec2 texture_position;
+
+// drawn as a 4 vertex triangle strip without a vertex buffer
+void main()
+{
+    const vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+
+    gl_Position = vec4(mix(screen_rect.xy, screen_rect.zw, corner), 0.0, 1.0);
+    texture_position = mix(texture_rect.xy, texture_rect.zw, corner);
+}
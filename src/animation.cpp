@@ -0,0 +1,77 @@
+#include "animation.hpp"
+#include "image.hpp"
+#include "trace.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+    std::string frame_file_path(const std::string& prefix, unsigned frame)
+    {
+        std::ostringstream stream;
+        stream << prefix << std::setw(5) << std::setfill('0') << frame << ".ppm";
+        return stream.str();
+    }
+}
+
+void render_animation(const AnimationSettings& settings, DiskCache* disk_cache)
+{
+    if (settings.frame_count == 0)
+        throw std::runtime_error{"animation needs at least one frame"};
+
+    const auto started = std::chrono::steady_clock::now();
+
+    const ReferenceOrbit reference_orbit{settings.end.center_x, settings.end.center_y, settings.max_iterations};
+
+    std::cerr << "reference orbit: " << reference_orbit.get_orbit().size() - 1 << " iterations, "
+              << std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count() << " s" << std::endl;
+
+    // The centre drifts towards the target in proportion to the remaining zoom, so the offset from the
+    // reference shrinks with the pixel size and stays representable as a double at any depth.
+    const double offset_x = (settings.start.center_x - settings.end.center_x).to_double();
+    const double offset_y = (settings.start.center_y - settings.end.center_y).to_double();
+    const double start_scale = settings.start.scale;
+    const double end_scale   = settings.end.scale;
+
+    for (unsigned frame = 0; frame < settings.frame_count; ++frame)
+    {
+        const TraceScope trace{"animation_frame"};
+
+        const double t = settings.frame_count > 1 ? static_cast<double>(frame) / (settings.frame_count - 1) : 1.0;
+        const double scale  = start_scale * std::pow(end_scale / start_scale, t);
+        const double weight = start_scale != end_scale ? (scale - end_scale) / (start_scale - end_scale) : 1.0 - t;
+
+        const View view{settings.end.center_x + HighPrecision::from_double(offset_x * weight),
+                        settings.end.center_y + HighPrecision::from_double(offset_y * weight), scale};
+
+        const Viewport viewport{::make_viewport(view, settings.width, settings.height)};
+        const std::string key{DiskCache::key(DiskCache::viewport_bounds(viewport), settings.max_iterations,
+                                             Precision::perturbation)};
+
+        IterationBuffer buffer;
+        if (!disk_cache || !disk_cache->load(key, buffer))
+        {
+            buffer = ::render_iterations(viewport, reference_orbit);
+            if (disk_cache)
+                disk_cache->store(key, buffer);
+        }
+        const std::vector<std::uint8_t> rgb{settings.equalize ? ::colorize_equalized(buffer, settings.max_iterations) :
+                                                                ::colorize(buffer, settings.max_iterations)};
+
+        if (settings.output == "-")
+            ::write_rgb(std::cout, rgb);
+        else
+            ::write_ppm(::frame_file_path(settings.output, frame), settings.width, settings.height, rgb);
+
+        std::cerr << "frame " << frame + 1 << '/' << settings.frame_count << " scale " << scale << std::endl;
+    }
+
+    std::cout.flush();
+    std::cerr << "total: " << std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count()
+              << " s" << std::endl;
+}
@@ -0,0 +1,26 @@
+#ifndef ANIMATION_HPP
+#define ANIMATION_HPP
+
+#include "kernel.hpp"
+#include "disk_cache.hpp"
+
+#include <string>
+
+struct AnimationSettings
+{
+    View start;
+    View end;
+    unsigned frame_count;
+    unsigned max_iterations;
+    int width;
+    int height;
+    std::string output;     // "-" streams raw RGB24 frames to stdout, otherwise a file name prefix
+    bool equalize;          // histogram-equalized colors, spread anew over every frame
+};
+
+// Zooms geometrically from start to end. Every frame is rendered by perturbation around one
+// reference orbit at the end view's centre, built once for the whole sequence. Frames found in
+// the disk cache (if any) are not recomputed.
+void render_animation(const AnimationSettings& settings, DiskCache* disk_cache);
+
+#endif
@@ -0,0 +1,112 @@
+#include "arguments.hpp"
+
+#include <stdexcept>
+
+namespace
+{
+    template <typename T, typename Parser>
+    T parse(const std::string& name, const std::string& text, Parser parser)
+    {
+        std::size_t parsed = 0;
+        T value{};
+        try {value = parser(text, &parsed);} catch (const std::exception&) {parsed = 0;}
+
+        if (text.empty() || parsed != text.size())
+            throw std::runtime_error{"invalid value for --" + name + ": " + text};
+
+        return value;
+    }
+}
+
+Arguments::Arguments(int argc, char* argv[])
+{
+    int index = 1;
+    if (index < argc && std::string{argv[index]}.compare(0, 2, "--") != 0)
+        mode = argv[index++];
+
+    std::vector<std::string>* current = nullptr;
+    for (; index < argc; ++index)
+    {
+        const std::string token{argv[index]};
+        if (token.compare(0, 2, "--") == 0 && token.size() > 2)
+            current = &options[token.substr(2)];
+        else if (current)
+            current->push_back(token);
+        else
+            throw std::runtime_error{"unexpected argument: " + token};
+    }
+}
+
+bool Arguments::has(const std::string& name) const
+{
+    return options.count(name) != 0;
+}
+
+const std::vector<std::string>& Arguments::values(const std::string& name, std::size_t count) const
+{
+    const auto option = options.find(name);
+    if (option == options.end())
+        throw std::runtime_error{"missing option --" + name};
+    if (option->second.size() != count)
+        throw std::runtime_error{"option --" + name + " expects " + std::to_string(count) + " value(s)"};
+
+    return option->second;
+}
+
+std::string Arguments::string_value(const std::string& name, const std::string& fallback) const
+{
+    return has(name) ? values(name, 1)[0] : fallback;
+}
+
+unsigned Arguments::unsigned_value(const std::string& name, unsigned fallback) const
+{
+    if (!has(name))
+        return fallback;
+
+    const std::string& text = values(name, 1)[0];
+    if (text[0] == '-')
+        throw std::runtime_error{"invalid value for --" + name + ": " + text};
+
+    return static_cast<unsigned>(::parse<unsigned long>(name, text,
+                [](const std::string& s, std::size_t* parsed) {return std::stoul(s, parsed);}));
+}
+
+double Arguments::double_value(const std::string& name, double fallback) const
+{
+    if (!has(name))
+        return fallback;
+
+    return ::parse<double>(name, values(name, 1)[0],
+                [](const std::string& s, std::size_t* parsed) {return std::stod(s, parsed);});
+}
+
+std::pair<int, int> Arguments::size_value(const std::string& name, std::pair<int, int> fallback) const
+{
+    if (!has(name))
+        return fallback;
+
+    const std::string& text = values(name, 1)[0];
+    const std::size_t separator = text.find('x');
+    if (separator == std::string::npos)
+        throw std::runtime_error{"invalid value for --" + name + ": " + text};
+
+    const auto to_int = [](const std::string& s, std::size_t* parsed) {return std::stoi(s, parsed);};
+    const std::pair<int, int> size{::parse<int>(name, text.substr(0, separator), to_int),
+                                   ::parse<int>(name, text.substr(separator + 1), to_int)};
+    if (size.first <= 0 || size.second <= 0)
+        throw std::runtime_error{"invalid value for --" + name + ": " + text};
+
+    return size;
+}
+
+View Arguments::view_value(const std::string& name) const
+{
+    const std::vector<std::string>& view = values(name, 3);
+
+    const double scale = ::parse<double>(name, view[2],
+                [](const std::string& s, std::size_t* parsed) {return std::stod(s, parsed);});
+    if (!(scale > 0.0))
+        throw std::runtime_error{"invalid value for --" + name + ": scale must be positive"};
+
+    return {HighPrecision::from_string(view[0]), HighPrecision::from_string(view[1]), scale};
+}
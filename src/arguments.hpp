@@ -0,0 +1,33 @@
+#ifndef ARGUMENTS_HPP
+#define ARGUMENTS_HPP
+
+#include "kernel.hpp"
+
+#include <map>
+#include <vector>
+#include <string>
+#include <utility>
+
+// Command line of the form "<mode> --name value... --flag". Every token up to the next "--name"
+// belongs to the preceding option.
+class Arguments
+{
+    std::string mode;
+    std::map<std::string, std::vector<std::string>> options;
+
+public:
+    Arguments(int argc, char* argv[]);
+
+    const std::string& get_mode() const noexcept {return mode;}
+
+    bool has(const std::string& name) const;
+    const std::vector<std::string>& values(const std::string& name, std::size_t count) const;
+
+    std::string string_value(const std::string& name, const std::string& fallback) const;
+    unsigned unsigned_value(const std::string& name, unsigned fallback) const;
+    double double_value(const std::string& name, double fallback) const;
+    std::pair<int, int> size_value(const std::string& name, std::pair<int, int> fallback) const;
+    View view_value(const std::string& name) const;
+};
+
+#endif
@@ -0,0 +1,120 @@
+#include "benchmark.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <stdexcept>
+#include <thread>
+#include <chrono>
+#include <numeric>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <functional>
+
+namespace
+{
+    struct BenchmarkView
+    {
+        const char* name;
+        const char* center_x;
+        const char* center_y;
+        double scale;
+        unsigned max_iterations;
+    };
+
+    const BenchmarkView VIEWS[] = {
+        {"full_set",        "-0.75",  "0",      1.25,  1000},
+        {"seahorse_valley", "-0.745", "0.113",  0.01,  2000},
+        {"elephant_valley", "0.2925", "0.0149", 0.01,  2000},
+        // period-17 nucleus on the real axis
+        {"minibrot_1e-12",  "-1.9962982570877986746792250882105533639142217461915663861947", "0", 3e-12, 5000},
+        // Misiurewicz point, spirals at every depth
+        {"deep_zoom_1e-50", "0", "1", 1e-50, 1000},
+    };
+
+    constexpr Precision PRECISIONS[] = {Precision::fp32, Precision::fp64, Precision::perturbation};
+    // the iteration shader has no perturbation
+    constexpr Precision GPU_PRECISIONS[] = {Precision::fp32, Precision::fp64};
+
+    constexpr double FP32_PIXEL_LIMIT = 1e-6;
+
+    // Precisions below their resolution limit would time a render of noise.
+    bool resolves(Precision precision, double pixel_size) noexcept
+    {
+        switch (precision)
+        {
+            case Precision::fp32:         return pixel_size > FP32_PIXEL_LIMIT;
+            case Precision::fp64:         return ::default_precision(pixel_size) == Precision::fp64;
+            case Precision::perturbation: return true;
+        }
+        return false;
+    }
+
+    BenchmarkRun render_cpu(const Viewport& viewport, unsigned max_iterations, Precision precision, unsigned thread_count)
+    {
+        const auto started = std::chrono::steady_clock::now();
+        const IterationBuffer buffer{::render_iterations(viewport, max_iterations, precision, thread_count)};
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+        const std::uint64_t skipped_iterations = static_cast<std::uint64_t>(buffer.series_skip) * buffer.iterations.size();
+        return {seconds, std::accumulate(buffer.iterations.begin(), buffer.iterations.end(), std::uint64_t{0}) -
+                         skipped_iterations, skipped_iterations};
+    }
+}
+
+void run_benchmark(const BenchmarkSettings& settings, std::ostream& output, const GpuRenderer& gpu_renderer)
+{
+    if (settings.width <= 0 || settings.height <= 0 || settings.repeat == 0)
+        throw std::runtime_error{"invalid benchmark settings"};
+
+    const unsigned thread_count = settings.thread_count ? settings.thread_count :
+                                  std::max(std::thread::hardware_concurrency(), 1U);
+
+    output << "{\n  \"width\": " << settings.width << ",\n  \"height\": " << settings.height
+           << ",\n  \"threads\": " << thread_count << ",\n  \"repeat\": " << settings.repeat
+           << ",\n  \"gpu\": " << (gpu_renderer ? "true" : "false") << ",\n  \"results\": [";
+
+    const char* separator = "\n";
+    const auto measure = [&](const BenchmarkView& view, const std::string& backend, const std::function<BenchmarkRun()>& render)
+    {
+        BenchmarkRun best{};
+        for (unsigned run = 0; run < settings.repeat; ++run)
+        {
+            const BenchmarkRun result{render()};
+            if (run == 0 || result.seconds < best.seconds)
+                best = result;
+        }
+
+        const double pixels = static_cast<double>(settings.width) * settings.height;
+        std::cerr << view.name << ' ' << backend << ": " << best.seconds << " s" << std::endl;
+
+        output << separator << std::fixed << std::setprecision(6)
+               << "    {\"view\": \"" << view.name << "\", \"backend\": \"" << backend
+               << "\", \"max_iterations\": " << view.max_iterations << ", \"iterations\": " << best.iterations
+               << ", \"skipped_iterations\": " << best.skipped_iterations
+               << ", \"wall_seconds\": " << best.seconds
+               << ", \"mpixels_per_second\": " << pixels / best.seconds * 1e-6
+               << ", \"giterations_per_second\": " << static_cast<double>(best.iterations) / best.seconds * 1e-9 << "}";
+        separator = ",\n";
+    };
+
+    for (const BenchmarkView& view : VIEWS)
+    {
+        const Viewport viewport{::make_viewport({HighPrecision::from_string(view.center_x),
+                                                 HighPrecision::from_string(view.center_y), view.scale},
+                                                settings.width, settings.height)};
+
+        for (const Precision precision : PRECISIONS)
+            if (::resolves(precision, viewport.pixel_size))
+                measure(view, ::precision_name(precision),
+                        [&] {return ::render_cpu(viewport, view.max_iterations, precision, thread_count);});
+
+        if (gpu_renderer)
+            for (const Precision precision : GPU_PRECISIONS)
+                if (::resolves(precision, viewport.pixel_size))
+                    measure(view, std::string{"gl_"} + ::precision_name(precision),
+                            [&] {return gpu_renderer(viewport, view.max_iterations, precision);});
+    }
+
+    output << "\n  ]\n}" << std::endl;
+}
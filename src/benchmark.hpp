@@ -0,0 +1,36 @@
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include "kernel.hpp"
+
+#include <ostream>
+#include <cstdint>
+#include <functional>
+
+struct BenchmarkSettings
+{
+    int width;
+    int height;
+    unsigned repeat;            // each measurement keeps the fastest of this many renders
+    unsigned thread_count;
+};
+
+// One render of a view.
+struct BenchmarkRun
+{
+    double seconds;
+    std::uint64_t iterations;           // run, not skipped
+    std::uint64_t skipped_iterations;   // by series approximation or a shader's early-outs
+};
+
+// Renders a view with the viewer's iteration shader at fp32 or fp64, see GpuBenchmark.
+using GpuRenderer = std::function<BenchmarkRun(const Viewport& viewport, unsigned max_iterations, Precision precision)>;
+
+// Renders a fixed set of well-known views with every CPU precision that can resolve them and writes
+// wall time, Mpixels/s and G-iterations/s per view and precision as JSON. With a GPU renderer the
+// shader's fp32 and fp64 are measured as well, as backends gl_fp32 and gl_fp64, timed on the GPU.
+// Views and iteration budgets never change, so results are comparable across releases on the same
+// machine.
+void run_benchmark(const BenchmarkSettings& settings, std::ostream& output, const GpuRenderer& gpu_renderer = nullptr);
+
+#endif
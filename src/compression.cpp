@@ -0,0 +1,90 @@
+#include "compression.hpp"
+
+#include <zlib.h>
+
+#include <stdexcept>
+
+namespace
+{
+    constexpr std::size_t HEADER_SIZE = 8;
+    constexpr std::uint32_t MAX_DIMENSION = 1U << 15;
+
+    void put_u32(unsigned char* output, std::uint32_t value) noexcept
+    {
+        for (int i = 0; i < 4; ++i)
+            output[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+
+    std::uint32_t get_u32(const unsigned char* input) noexcept
+    {
+        std::uint32_t value = 0;
+        for (int i = 0; i < 4; ++i)
+            value |= static_cast<std::uint32_t>(input[i]) << (8 * i);
+        return value;
+    }
+}
+
+std::string compress_iterations(const IterationBuffer& buffer)
+{
+    std::string deltas(buffer.iterations.size() * 4, '\0');
+    auto* const raw = reinterpret_cast<unsigned char*>(&deltas[0]);
+
+    for (int row = 0; row < buffer.height; ++row)
+    {
+        std::uint32_t previous = 0;
+        for (int column = 0; column < buffer.width; ++column)
+        {
+            const std::size_t index = static_cast<std::size_t>(row) * buffer.width + column;
+            ::put_u32(raw + index * 4, buffer.iterations[index] - previous);
+            previous = buffer.iterations[index];
+        }
+    }
+
+    uLongf compressed_size = ::compressBound(static_cast<uLong>(deltas.size()));
+    std::string data(HEADER_SIZE + compressed_size, '\0');
+    auto* const output = reinterpret_cast<unsigned char*>(&data[0]);
+
+    ::put_u32(output,     static_cast<std::uint32_t>(buffer.width));
+    ::put_u32(output + 4, static_cast<std::uint32_t>(buffer.height));
+
+    if (::compress2(output + HEADER_SIZE, &compressed_size, raw, static_cast<uLong>(deltas.size()), Z_BEST_SPEED) != Z_OK)
+        throw std::runtime_error{"iteration buffer compression error"};
+
+    data.resize(HEADER_SIZE + compressed_size);
+    return data;
+}
+
+IterationBuffer decompress_iterations(const std::string& data)
+{
+    if (data.size() < HEADER_SIZE)
+        throw std::runtime_error{"truncated iteration buffer"};
+
+    const auto* const input = reinterpret_cast<const unsigned char*>(data.data());
+    const std::uint32_t width  = ::get_u32(input);
+    const std::uint32_t height = ::get_u32(input + 4);
+    if (width > MAX_DIMENSION || height > MAX_DIMENSION)
+        throw std::runtime_error{"corrupt iteration buffer"};
+
+    IterationBuffer buffer{static_cast<int>(width), static_cast<int>(height),
+                           std::vector<std::uint32_t>(static_cast<std::size_t>(width) * height)};
+
+    std::string deltas(buffer.iterations.size() * 4, '\0');
+    uLongf size = static_cast<uLongf>(deltas.size());
+    if (::uncompress(reinterpret_cast<unsigned char*>(&deltas[0]), &size,
+                     input + HEADER_SIZE, static_cast<uLong>(data.size() - HEADER_SIZE)) != Z_OK || size != deltas.size())
+        throw std::runtime_error{"corrupt iteration buffer"};
+
+    const auto* const raw = reinterpret_cast<const unsigned char*>(deltas.data());
+    for (std::uint32_t row = 0; row < height; ++row)
+    {
+        std::uint32_t previous = 0;
+        for (std::uint32_t column = 0; column < width; ++column)
+        {
+            const std::size_t index = static_cast<std::size_t>(row) * width + column;
+            previous += ::get_u32(raw + index * 4);
+            buffer.iterations[index] = previous;
+        }
+    }
+
+    return buffer;
+}
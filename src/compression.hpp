@@ -0,0 +1,13 @@
+#ifndef COMPRESSION_HPP
+#define COMPRESSION_HPP
+
+#include "kernel.hpp"
+
+#include <string>
+
+// Iteration buffers are stored and transmitted as width, height and a zlib stream of horizontal
+// deltas, which turns the large flat regions of a render into long runs of zeros.
+std::string compress_iterations(const IterationBuffer& buffer);
+IterationBuffer decompress_iterations(const std::string& data);
+
+#endif
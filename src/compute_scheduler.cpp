@@ -0,0 +1,68 @@
+#include "compute_scheduler.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+    // weight of the newest batch in the cost estimate
+    constexpr double SMOOTHING = 0.25;
+}
+
+ComputeScheduler::ComputeScheduler(double budget) :
+    budget{budget}, started{::create_query(GL_TIMESTAMP)}, finished{::create_query(GL_TIMESTAMP)}
+{
+    if (!(budget > 0.0))
+        throw std::runtime_error{"compute budget must be positive"};
+}
+
+ComputeScheduler::~ComputeScheduler()
+{
+    if (fence)
+        ::glDeleteSync(fence);
+}
+
+void ComputeScheduler::collect()
+{
+    GLuint64 start = 0;
+    GLuint64 end = 0;
+    ::glGetQueryObjectui64v(started, GL_QUERY_RESULT, &start);
+    ::glGetQueryObjectui64v(finished, GL_QUERY_RESULT, &end);
+
+    const double cost = (end > start ? end - start : 0) * 1e-6 / batch_tiles;
+    tile_cost += SMOOTHING * (cost - tile_cost);
+
+    ::glDeleteSync(fence);
+    fence = nullptr;
+}
+
+double ComputeScheduler::begin_batch()
+{
+    if (fence)
+    {
+        const GLenum status = ::glClientWaitSync(fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            return 0;
+
+        collect();
+    }
+
+    ::glQueryCounter(started, GL_TIMESTAMP);
+    open = true;
+
+    return std::min<double>(MAX_BATCH, budget / std::max(tile_cost, 1e-3));
+}
+
+void ComputeScheduler::end_batch(double tiles)
+{
+    if (!open)
+        return;
+
+    open = false;
+    if (!(tiles > 0.0))
+        return;
+
+    ::glQueryCounter(finished, GL_TIMESTAMP);
+    fence = ::glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    batch_tiles = tiles;
+}
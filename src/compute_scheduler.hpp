@@ -0,0 +1,43 @@
+#ifndef COMPUTE_SCHEDULER_HPP
+#define COMPUTE_SCHEDULER_HPP
+
+#include "gl_resources.hpp"
+
+// Sizes the batches of escape-time tiles dispatched per frame from their measured GPU cost. Each
+// batch is bracketed by timestamp queries, with nothing but the tiles' draws between them, and
+// followed by a fence; the next batch is only dispatched once that fence has signalled, so at most
+// one batch of compute is ever queued ahead of the frames being drawn, and its result then tunes the
+// cost per tile used to fill the budget. A tile that alone costs more than the budget is dispatched
+// a band of rows at a time, so that no batch runs much longer than the budget.
+class ComputeScheduler
+{
+    static constexpr unsigned MAX_BATCH = 64;
+
+    double budget;              // GPU milliseconds per batch
+    double tile_cost = 1.0;     // milliseconds per whole tile, smoothed over batches
+
+    GLquery started;
+    GLquery finished;
+    GLsync fence = nullptr;
+    double batch_tiles = 0.0;
+    bool open = false;
+
+    void collect();
+
+public:
+    explicit ComputeScheduler(double budget);
+    ComputeScheduler(const ComputeScheduler&) = delete;
+    ~ComputeScheduler();
+
+    ComputeScheduler& operator=(const ComputeScheduler&) = delete;
+
+    // Returns how many tiles fit into the budget, 0 while the previous batch is still running. Below 1
+    // when one tile costs more than the budget: the fraction of a tile's rows that fits.
+    double begin_batch();
+    // tiles is how much was actually dispatched, in tiles; an empty batch is dropped.
+    void end_batch(double tiles);
+
+    double tile_milliseconds() const noexcept {return tile_cost;}
+};
+
+#endif
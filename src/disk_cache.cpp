@@ -0,0 +1,201 @@
+#include "disk_cache.hpp"
+#include "compression.hpp"
+#include "file_system.hpp"
+#include "hash.hpp"
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <algorithm>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <functional>
+
+namespace
+{
+    const std::string MAGIC = "MBIC";
+    const std::string SUFFIX = ".iter";
+
+    std::string hash_name(const std::string& key)
+    {
+        char name[17];
+        std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(::fnv1a(key)));
+        return name + SUFFIX;
+    }
+}
+
+DiskCache::DiskCache(const std::string& directory, std::uintmax_t capacity) : directory{directory}, capacity{capacity}
+{
+    ::make_directories(directory);
+
+    DIR* const stream = ::opendir(directory.c_str());
+    if (!stream)
+        throw std::runtime_error{"cannot open " + directory + ": " + std::strerror(errno)};
+
+    struct Found {std::string name; std::uintmax_t size; time_t modified;};
+    std::vector<Found> found;
+
+    while (const dirent* const entry = ::readdir(stream))
+    {
+        const std::string name{entry->d_name};
+        struct stat status;
+        if (name.size() > SUFFIX.size() && name.compare(name.size() - SUFFIX.size(), SUFFIX.size(), SUFFIX) == 0 &&
+            ::stat(file_path(name).c_str(), &status) == 0)
+            found.push_back({name, static_cast<std::uintmax_t>(status.st_size), status.st_mtime});
+    }
+    ::closedir(stream);
+
+    std::sort(found.begin(), found.end(), [](const Found& a, const Found& b) {return a.modified > b.modified;});
+    for (const Found& file : found)
+    {
+        entries.push_back({file.name, file.size});
+        index.emplace(file.name, std::prev(entries.end()));
+        total_size += file.size;
+    }
+
+    evict();
+}
+
+std::string DiskCache::key(const std::string& bounds, unsigned max_iterations, Precision precision)
+{
+    return bounds + ";precision=" + ::precision_name(precision) + ";max_iterations=" + std::to_string(max_iterations);
+}
+
+std::string DiskCache::viewport_bounds(const Viewport& viewport, const std::string& backend)
+{
+    char pixel_size[32];
+    std::snprintf(pixel_size, sizeof(pixel_size), "%a", viewport.pixel_size);
+
+    return backend + ':' + viewport.center_x.to_string() + ',' + viewport.center_y.to_string() + ',' + pixel_size + ',' +
+           std::to_string(viewport.width) + 'x' + std::to_string(viewport.height);
+}
+
+std::string DiskCache::default_directory()
+{
+    if (const char* const cache_home = std::getenv("XDG_CACHE_HOME"))
+        if (*cache_home)
+            return std::string{cache_home} + "/mandelbrotgl";
+
+    if (const char* const home = std::getenv("HOME"))
+        if (*home)
+            return std::string{home} + "/.cache/mandelbrotgl";
+
+    return ".mandelbrotgl-cache";
+}
+
+std::string DiskCache::file_path(const std::string& name) const
+{
+    return directory + '/' + name;
+}
+
+void DiskCache::touch(const std::string& name)
+{
+    ::utimensat(AT_FDCWD, file_path(name).c_str(), nullptr, 0);
+}
+
+void DiskCache::evict()
+{
+    while (total_size > capacity && !entries.empty())
+    {
+        const Entry& oldest = entries.back();
+        ::unlink(file_path(oldest.name).c_str());
+
+        total_size -= oldest.size;
+        index.erase(oldest.name);
+        entries.pop_back();
+    }
+}
+
+bool DiskCache::load(const std::string& key, IterationBuffer& buffer)
+{
+    const std::string name{::hash_name(key)};
+
+    std::ifstream stream{file_path(name), std::ios::in | std::ios::binary};
+    if (!stream)
+        return false;
+
+    const std::string contents{std::istreambuf_iterator<char>{stream}, std::istreambuf_iterator<char>{}};
+
+    try
+    {
+        if (contents.compare(0, MAGIC.size(), MAGIC) != 0 ||
+            contents.compare(MAGIC.size(), key.size() + 1, key + '\0') != 0)
+            return false;   // hash collision or foreign file
+
+        buffer = ::decompress_iterations(contents.substr(MAGIC.size() + key.size() + 1));
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << "disk cache: " << name << ": " << ex.what() << std::endl;
+        return false;
+    }
+
+    const std::lock_guard<std::mutex> lock{mutex};
+
+    const auto found = index.find(name);
+    if (found != index.end())
+        entries.splice(entries.begin(), entries, found->second);
+    else
+    {
+        entries.push_front({name, contents.size()});
+        index.emplace(name, entries.begin());
+        total_size += contents.size();
+    }
+    touch(name);
+
+    return true;
+}
+
+void DiskCache::store(const std::string& key, const IterationBuffer& buffer)
+{
+    const std::string name{::hash_name(key)};
+
+    try
+    {
+        const std::string contents{MAGIC + key + '\0' + ::compress_iterations(buffer)};
+
+        const std::string temporary = file_path(name) + ".tmp" + std::to_string(::getpid()) + '-' +
+                                      std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+        {
+            std::ofstream stream{temporary, std::ios::out | std::ios::binary};
+            stream.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+            if (!stream)
+                throw std::runtime_error{"cannot write " + temporary};
+        }
+        if (std::rename(temporary.c_str(), file_path(name).c_str()) != 0)
+        {
+            std::remove(temporary.c_str());
+            throw std::runtime_error{"cannot rename " + temporary + ": " + std::strerror(errno)};
+        }
+
+        const std::lock_guard<std::mutex> lock{mutex};
+
+        const auto found = index.find(name);
+        if (found != index.end())
+        {
+            total_size -= found->second->size;
+            entries.erase(found->second);
+            index.erase(found);
+        }
+        entries.push_front({name, contents.size()});
+        index.emplace(name, entries.begin());
+        total_size += contents.size();
+
+        evict();
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << "disk cache: " << ex.what() << std::endl;
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef DISK_CACHE_HPP
+#define DISK_CACHE_HPP
+
+#include "kernel.hpp"
+
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+
+// Content-addressed store of iteration buffers. Each entry is one file named after a hash of
+// bounds, precision and max_iterations; the least recently used files are deleted once the
+// directory grows past the capacity. File modification times carry the LRU order across runs.
+class DiskCache
+{
+    struct Entry
+    {
+        std::string name;
+        std::uintmax_t size;
+    };
+
+    std::string directory;
+    std::uintmax_t capacity;
+    std::uintmax_t total_size = 0;
+
+    std::mutex mutex;
+    std::list<Entry> entries;   // most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+
+    std::string file_path(const std::string& name) const;
+    void touch(const std::string& name);
+    void evict();
+
+public:
+    DiskCache(const std::string& directory, std::uintmax_t capacity);
+    DiskCache(const DiskCache&) = delete;
+
+    DiskCache& operator=(const DiskCache&) = delete;
+
+    // bounds is any canonical description of the sampled grid, e.g. viewport_bounds().
+    static std::string key(const std::string& bounds, unsigned max_iterations, Precision precision);
+    // backend tells apart buffers computed by different kernels for the same grid.
+    static std::string viewport_bounds(const Viewport& viewport, const std::string& backend = "cpu");
+    static std::string default_directory();
+
+    // Both report failures on stderr instead of throwing: a broken cache must not stop a render.
+    bool load(const std::string& key, IterationBuffer& buffer);
+    void store(const std::string& key, const IterationBuffer& buffer);
+};
+
+#endif
@@ -0,0 +1,419 @@
+#include "distributed.hpp"
+#include "compression.hpp"
+#include "disk_cache.hpp"
+#include "image.hpp"
+#include "socket.hpp"
+#include "trace.hpp"
+
+#include <sys/socket.h>
+#include <poll.h>
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+    constexpr std::size_t MAX_LINE_SIZE = 1024;
+    constexpr std::size_t MAX_RESULT_SIZE = std::size_t{1} << 28;
+    constexpr int MAX_JOB_SIZE = 4096;
+    // between WORKING lines; a job may take any time as long as they keep coming
+    constexpr std::chrono::seconds HEARTBEAT_INTERVAL{1};
+
+    // Buffers what arrives past the end of a line so the binary payload that follows is not lost.
+    class Connection
+    {
+        Socket socket;
+        std::string pending;
+
+        void fill()
+        {
+            char buffer[4096];
+            const std::size_t received = ::receive_some(socket, buffer, sizeof(buffer));
+            if (!received)
+                throw std::runtime_error{"connection closed by peer"};
+
+            pending.append(buffer, received);
+        }
+
+    public:
+        explicit Connection(Socket socket) noexcept : socket{std::move(socket)} {}
+
+        std::string read_line()
+        {
+            std::size_t end;
+            while ((end = pending.find('\n')) == std::string::npos)
+            {
+                if (pending.size() > MAX_LINE_SIZE)
+                    throw std::runtime_error{"line too long"};
+                fill();
+            }
+
+            const std::string line = pending.substr(0, end);
+            pending.erase(0, end + 1);
+            return line;
+        }
+
+        std::string read_bytes(std::size_t size)
+        {
+            while (pending.size() < size)
+                fill();
+
+            const std::string bytes = pending.substr(0, size);
+            pending.erase(0, size);
+            return bytes;
+        }
+
+        void write(const std::string& data)
+        {
+            ::send_all(socket, data.data(), data.size());
+        }
+
+        const Socket& get_socket() const noexcept {return socket;}
+    };
+
+    std::string format_pixel_size(double pixel_size)
+    {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%a", pixel_size);
+        return text;
+    }
+
+    struct Job
+    {
+        Viewport viewport;
+        int column;
+        int row;
+    };
+
+    // Sub-viewport whose pixel centres coincide with those of the full image.
+    Viewport job_viewport(const Viewport& image, int column, int row, int width, int height)
+    {
+        return {image.center_x + HighPrecision::from_double((column + 0.5 * (width - image.width)) * image.pixel_size),
+                image.center_y + HighPrecision::from_double((0.5 * (image.height - height) - row) * image.pixel_size),
+                image.pixel_size, width, height};
+    }
+
+    class Coordinator
+    {
+        const CoordinatorSettings& settings;
+        DiskCache* disk_cache;
+        std::vector<Job> jobs;
+        std::vector<std::string> keys;  // of each job in the disk cache
+        IterationBuffer image;
+
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::deque<std::size_t> queue;
+        std::vector<bool> finished;
+        std::size_t remaining;
+        unsigned long requeued = 0;
+        unsigned long cached = 0;
+
+        // Blocks until a job is queued or every job is finished; false in the latter case.
+        bool next_job(std::size_t& job)
+        {
+            std::unique_lock<std::mutex> lock{mutex};
+            changed.wait(lock, [this] {return !queue.empty() || !remaining;});
+
+            if (!remaining)
+                return false;
+
+            job = queue.front();
+            queue.pop_front();
+            return true;
+        }
+
+        void requeue(std::size_t job)
+        {
+            {
+                const std::lock_guard<std::mutex> lock{mutex};
+                if (finished[job])
+                    return;
+
+                queue.push_front(job);
+                ++requeued;
+            }
+            changed.notify_one();
+        }
+
+        // with the mutex held, or before any worker thread runs
+        void place(std::size_t job, const IterationBuffer& buffer)
+        {
+            const Job& placed = jobs[job];
+            for (int row = 0; row < buffer.height; ++row)
+                std::copy_n(&buffer.iterations[static_cast<std::size_t>(row) * buffer.width], buffer.width,
+                            &image.iterations[static_cast<std::size_t>(placed.row + row) * image.width + placed.column]);
+
+            finished[job] = true;
+            --remaining;
+        }
+
+        void complete(std::size_t job, const IterationBuffer& buffer)
+        {
+            {
+                const std::lock_guard<std::mutex> lock{mutex};
+                if (finished[job])
+                    return;
+
+                place(job, buffer);
+                std::cerr << "\rjobs: " << jobs.size() - remaining << '/' << jobs.size() << std::flush;
+            }
+            changed.notify_all();
+
+            if (disk_cache)
+                disk_cache->store(keys[job], buffer);
+        }
+
+        void serve_worker(Socket socket, unsigned worker)
+        {
+            Connection connection{std::move(socket)};
+
+            const timeval timeout{static_cast<time_t>(settings.stall_timeout), 0};
+            ::setsockopt(connection.get_socket(), SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+            std::size_t job = jobs.size();
+            try
+            {
+                if (connection.read_line() != "HELLO")
+                    throw std::runtime_error{"unexpected greeting"};
+
+                while (next_job(job))
+                {
+                    const Viewport& viewport = jobs[job].viewport;
+
+                    std::ostringstream line;
+                    line << "JOB " << job << ' ' << viewport.center_x.to_string() << ' ' << viewport.center_y.to_string()
+                         << ' ' << ::format_pixel_size(viewport.pixel_size) << ' ' << viewport.width << ' ' << viewport.height
+                         << ' ' << settings.max_iterations << ' ' << ::precision_name(settings.precision) << '\n';
+                    connection.write(line.str());
+
+                    // the receive timeout runs from one heartbeat to the next, not over the whole job
+                    const std::string heartbeat{"WORKING " + std::to_string(job)};
+                    std::string reply;
+                    while ((reply = connection.read_line()) == heartbeat);
+
+                    std::istringstream result{reply};
+                    std::string word;
+                    std::size_t id, size;
+                    if (!(result >> word >> id >> size) || word != "RESULT" || id != job || size > MAX_RESULT_SIZE)
+                        throw std::runtime_error{"malformed result"};
+
+                    const IterationBuffer buffer{::decompress_iterations(connection.read_bytes(size))};
+                    if (buffer.width != viewport.width || buffer.height != viewport.height)
+                        throw std::runtime_error{"result size does not match job " + std::to_string(job)};
+
+                    complete(job, buffer);
+                    job = jobs.size();
+                }
+
+                connection.write("DONE\n");
+            }
+            catch (const std::exception& ex)
+            {
+                std::cerr << "\nworker " << worker << ": " << ex.what();
+                if (job < jobs.size())
+                {
+                    std::cerr << ", job " << job << " re-queued";
+                    requeue(job);
+                }
+                std::cerr << std::endl;
+            }
+        }
+
+    public:
+        Coordinator(const CoordinatorSettings& settings, DiskCache* disk_cache) :
+            settings{settings}, disk_cache{disk_cache}, image{settings.width, settings.height, {}}
+        {
+            if (settings.width <= 0 || settings.height <= 0)
+                throw std::runtime_error{"invalid image size"};
+            if (settings.job_size <= 0 || settings.job_size > MAX_JOB_SIZE)
+                throw std::runtime_error{"invalid job size"};
+            if (settings.stall_timeout <= HEARTBEAT_INTERVAL.count())
+                throw std::runtime_error{"stall timeout must be longer than the heartbeat interval of " +
+                                         std::to_string(HEARTBEAT_INTERVAL.count()) + " s"};
+
+            const Viewport viewport{::make_viewport(settings.view, settings.width, settings.height)};
+            for (int row = 0; row < settings.height; row += settings.job_size)
+            {
+                for (int column = 0; column < settings.width; column += settings.job_size)
+                {
+                    const int width  = std::min(settings.job_size, settings.width  - column);
+                    const int height = std::min(settings.job_size, settings.height - row);
+                    jobs.push_back({::job_viewport(viewport, column, row, width, height), column, row});
+                    // the workers run the CPU kernels, so their buffers are shared with animate's
+                    keys.push_back(DiskCache::key(DiskCache::viewport_bounds(jobs.back().viewport),
+                                                  settings.max_iterations, settings.precision));
+                }
+            }
+
+            image.iterations.resize(static_cast<std::size_t>(settings.width) * settings.height);
+            finished.resize(jobs.size());
+            remaining = jobs.size();
+
+            // jobs found in the disk cache are never handed out
+            for (std::size_t job = 0; job < jobs.size(); ++job)
+            {
+                IterationBuffer buffer;
+                if (disk_cache && disk_cache->load(keys[job], buffer) &&
+                    buffer.width == jobs[job].viewport.width && buffer.height == jobs[job].viewport.height)
+                {
+                    place(job, buffer);
+                    ++cached;
+                }
+                else
+                    queue.push_back(job);
+            }
+        }
+
+        void run()
+        {
+            const auto started = std::chrono::steady_clock::now();
+
+            const Socket listener{::listen_socket(settings.port)};
+            std::cerr << "coordinating " << jobs.size() << " jobs on 127.0.0.1:" << settings.port << ", "
+                      << cached << " found in the disk cache" << std::endl;
+
+            std::vector<std::thread> threads;
+            for (;;)
+            {
+                {
+                    const std::lock_guard<std::mutex> lock{mutex};
+                    if (!remaining)
+                        break;
+                }
+
+                pollfd readable{listener, POLLIN, 0};
+                if (::poll(&readable, 1, 100) > 0)
+                {
+                    // out of descriptors the worker waits in the backlog for a while
+                    Socket connection{::accept_connection(listener)};
+                    if (connection < 0)
+                    {
+                        std::this_thread::sleep_for(std::chrono::milliseconds{100});
+                        continue;
+                    }
+
+                    const unsigned worker = static_cast<unsigned>(threads.size());
+                    threads.emplace_back(&Coordinator::serve_worker, this, std::move(connection), worker);
+                }
+            }
+            for (std::thread& thread : threads)
+                thread.join();
+
+            std::cerr << "\n" << threads.size() << " worker connections, " << requeued << " jobs re-queued, "
+                      << std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count() << " s" << std::endl;
+
+            ::write_ppm(settings.output, image.width, image.height,
+                        settings.equalize ? ::colorize_equalized(image, settings.max_iterations) :
+                                            ::colorize(image, settings.max_iterations));
+        }
+    };
+
+    Job parse_job(const std::string& line, std::size_t& id, unsigned& max_iterations, Precision& precision)
+    {
+        std::istringstream stream{line};
+        std::string word, center_x, center_y, pixel_size, precision_name;
+        Job job{};
+
+        if (!(stream >> word >> id >> center_x >> center_y >> pixel_size >> job.viewport.width >> job.viewport.height
+                     >> max_iterations >> precision_name) || word != "JOB")
+            throw std::runtime_error{"malformed job: " + line};
+
+        job.viewport.center_x = HighPrecision::from_string(center_x);
+        job.viewport.center_y = HighPrecision::from_string(center_y);
+        job.viewport.pixel_size = std::strtod(pixel_size.c_str(), nullptr);
+        precision = ::parse_precision(precision_name);
+
+        if (job.viewport.width <= 0 || job.viewport.width > MAX_JOB_SIZE ||
+            job.viewport.height <= 0 || job.viewport.height > MAX_JOB_SIZE || !(job.viewport.pixel_size > 0.0))
+            throw std::runtime_error{"invalid job: " + line};
+
+        return job;
+    }
+
+    // Renders jobs until the coordinator sends DONE; throws when the connection is lost.
+    void serve_jobs(Connection& connection, unsigned thread_count, unsigned long& job_count)
+    {
+        connection.write("HELLO\n");
+
+        for (;;)
+        {
+            const std::string line{connection.read_line()};
+            if (line == "DONE")
+                return;
+
+            std::size_t id;
+            unsigned max_iterations;
+            Precision precision;
+            const Job job{::parse_job(line, id, max_iterations, precision)};
+            const TraceScope trace{"render_job"};
+
+            std::future<std::string> rendering{std::async(std::launch::async, [&]
+            {
+                return ::compress_iterations(::render_iterations(job.viewport, max_iterations, precision, thread_count));
+            })};
+            while (rendering.wait_for(HEARTBEAT_INTERVAL) != std::future_status::ready)
+                connection.write("WORKING " + std::to_string(id) + '\n');
+
+            const std::string data{rendering.get()};
+            connection.write("RESULT " + std::to_string(id) + ' ' + std::to_string(data.size()) + '\n' + data);
+            ++job_count;
+        }
+    }
+}
+
+void run_coordinator(const CoordinatorSettings& settings, DiskCache* disk_cache)
+{
+    Coordinator{settings, disk_cache}.run();
+}
+
+void run_worker(const WorkerSettings& settings)
+{
+    const auto started = std::chrono::steady_clock::now();
+    unsigned long job_count = 0;
+
+    auto retry_until = std::chrono::steady_clock::now() + std::chrono::seconds{settings.connect_timeout};
+    for (;;)
+    {
+        Socket socket;
+        try
+        {
+            socket = ::connect_socket(settings.host, settings.port);
+        }
+        catch (const std::exception&)
+        {
+            if (std::chrono::steady_clock::now() >= retry_until)
+                throw;
+
+            std::this_thread::sleep_for(std::chrono::milliseconds{250});
+            continue;
+        }
+
+        try
+        {
+            Connection connection{std::move(socket)};
+            ::serve_jobs(connection, settings.thread_count, job_count);
+            break;
+        }
+        catch (const std::exception& ex)
+        {
+            std::cerr << "worker: " << ex.what() << ", reconnecting" << std::endl;
+        }
+
+        retry_until = std::chrono::steady_clock::now() + std::chrono::seconds{settings.connect_timeout};
+    }
+
+    std::cerr << "worker: " << job_count << " jobs in "
+              << std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count() << " s" << std::endl;
+}
@@ -0,0 +1,44 @@
+#ifndef DISTRIBUTED_HPP
+#define DISTRIBUTED_HPP
+
+#include "kernel.hpp"
+#include "disk_cache.hpp"
+
+#include <string>
+
+// Line-based protocol over TCP. A worker opens with "HELLO"; the coordinator answers with
+//   JOB <id> <center_x> <center_y> <pixel_size> <width> <height> <max_iterations> <precision>
+// or DONE once every job is finished. While rendering, the worker sends "WORKING <id>" every second;
+// it answers a job with "RESULT <id> <size>" followed by size bytes of compress_iterations() output,
+// and receives the next JOB or DONE in return.
+
+struct CoordinatorSettings
+{
+    unsigned short port;
+    View view;
+    int width;
+    int height;
+    unsigned max_iterations;
+    Precision precision;
+    int job_size;               // edge of the square sub-images handed out as jobs
+    unsigned stall_timeout;     // seconds without a heartbeat from a busy worker before its job is re-queued
+    std::string output;         // PPM file
+    bool equalize;              // histogram-equalized colors
+};
+
+struct WorkerSettings
+{
+    std::string host;
+    unsigned short port;
+    unsigned thread_count;
+    unsigned connect_timeout;   // seconds to keep retrying an unreachable coordinator
+};
+
+// Splits the image into jobs and serves them to any number of workers until all are done, then
+// writes the colorized image. Jobs of workers that disconnect or stall are handed to another worker.
+// Jobs already in disk_cache (if any) are taken from there, and the results of the others stored.
+void run_coordinator(const CoordinatorSettings& settings, DiskCache* disk_cache);
+// Renders jobs until the coordinator reports that none are left, reconnecting after lost connections.
+void run_worker(const WorkerSettings& settings);
+
+#endif
@@ -0,0 +1,21 @@
+#include "file_system.hpp"
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+void make_directories(const std::string& path)
+{
+    for (std::size_t slash = path.find('/', 1);; slash = path.find('/', slash + 1))
+    {
+        const std::string prefix = path.substr(0, slash);
+        if (::mkdir(prefix.c_str(), 0755) < 0 && errno != EEXIST)
+            throw std::runtime_error{"cannot create " + prefix + ": " + std::strerror(errno)};
+
+        if (slash == std::string::npos)
+            break;
+    }
+}
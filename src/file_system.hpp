@@ -0,0 +1,9 @@
+#ifndef FILE_SYSTEM_HPP
+#define FILE_SYSTEM_HPP
+
+#include <string>
+
+// Creates the directory and every missing parent, like mkdir -p; throws if one cannot be created.
+void make_directories(const std::string& path);
+
+#endif
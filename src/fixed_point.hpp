@@ -0,0 +1,215 @@
+#ifndef FIXED_POINT_HPP
+#define FIXED_POINT_HPP
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <string>
+#include <stdexcept>
+#include <cctype>
+
+// Two's complement fixed-point number with a 32-bit integer part and FractionLimbs * 32 fractional bits.
+// Limbs are stored least significant first. Used for reference orbits and view centres that double
+// cannot represent once the zoom goes past ~1e-15.
+template <std::size_t FractionLimbs>
+class FixedPoint
+{
+public:
+    static constexpr std::size_t limb_count = FractionLimbs + 1;
+
+private:
+    std::array<std::uint32_t, limb_count> limbs{};
+
+    bool negative() const noexcept {return limbs[limb_count - 1] & 0x80000000U;}
+
+    FixedPoint negated() const noexcept
+    {
+        FixedPoint result;
+        std::uint64_t carry = 1;
+        for (std::size_t i = 0; i < limb_count; ++i)
+        {
+            carry += static_cast<std::uint32_t>(~limbs[i]);
+            result.limbs[i] = static_cast<std::uint32_t>(carry);
+            carry >>= 32;
+        }
+        return result;
+    }
+
+    FixedPoint magnitude() const noexcept {return negative() ? negated() : *this;}
+
+    void divide_small(std::uint32_t divisor) noexcept
+    {
+        std::uint64_t remainder = 0;
+        for (std::size_t i = limb_count; i-- > 0;)
+        {
+            const std::uint64_t value = (remainder << 32) | limbs[i];
+            limbs[i] = static_cast<std::uint32_t>(value / divisor);
+            remainder = value % divisor;
+        }
+    }
+
+public:
+    FixedPoint() noexcept = default;
+
+    static FixedPoint from_double(double value)
+    {
+        if (!std::isfinite(value) || std::fabs(value) >= 2147483648.0)
+            throw std::runtime_error{"fixed-point value out of range"};
+
+        FixedPoint result;
+        double remaining = std::fabs(value);
+        for (std::size_t i = limb_count; i-- > 0 && remaining != 0.0;)
+        {
+            const double limb = std::floor(remaining);
+            result.limbs[i] = static_cast<std::uint32_t>(limb);
+            remaining = (remaining - limb) * 4294967296.0;
+        }
+        return value < 0.0 ? result.negated() : result;
+    }
+
+    // Accepts plain decimal notation with an optional exponent, e.g. "-0.7436438870371587e-2".
+    static FixedPoint from_string(const std::string& text)
+    {
+        std::size_t position = 0;
+        bool minus = false;
+        if (position < text.size() && (text[position] == '-' || text[position] == '+'))
+            minus = text[position++] == '-';
+
+        std::string digits;
+        long point = -1;
+        for (; position < text.size(); ++position)
+        {
+            const char c = text[position];
+            if (std::isdigit(static_cast<unsigned char>(c)))
+                digits += c;
+            else if (c == '.' && point < 0)
+                point = static_cast<long>(digits.size());
+            else
+                break;
+        }
+        if (digits.empty())
+            throw std::runtime_error{"invalid number: " + text};
+        if (point < 0)
+            point = static_cast<long>(digits.size());
+
+        if (position < text.size())
+        {
+            if (text[position] != 'e' && text[position] != 'E')
+                throw std::runtime_error{"invalid number: " + text};
+            std::size_t parsed = 0;
+            const std::string exponent = text.substr(position + 1);
+            long shift = 0;
+            try {shift = std::stol(exponent, &parsed);} catch (const std::exception&) {parsed = 0;}
+            if (exponent.empty() || parsed != exponent.size())
+                throw std::runtime_error{"invalid number: " + text};
+            point += shift;
+        }
+
+        while (point < 0)
+        {
+            digits.insert(digits.begin(), '0');
+            ++point;
+        }
+        while (static_cast<long>(digits.size()) < point)
+            digits += '0';
+
+        FixedPoint result;
+        for (std::size_t i = digits.size(); i-- > static_cast<std::size_t>(point);)
+        {
+            result.limbs[limb_count - 1] += static_cast<std::uint32_t>(digits[i] - '0');
+            result.divide_small(10);
+        }
+        std::uint64_t integer = 0;
+        for (long i = 0; i < point; ++i)
+        {
+            integer = integer * 10 + static_cast<std::uint64_t>(digits[i] - '0');
+            if (integer >= 0x80000000ULL)
+                throw std::runtime_error{"fixed-point value out of range"};
+        }
+        result.limbs[limb_count - 1] = static_cast<std::uint32_t>(integer);
+
+        return minus ? result.negated() : result;
+    }
+
+    double to_double() const noexcept
+    {
+        const FixedPoint absolute = magnitude();
+        double result = 0.0;
+        for (std::size_t i = 0; i < limb_count; ++i)
+            result += std::ldexp(static_cast<double>(absolute.limbs[i]), 32 * (static_cast<int>(i) - static_cast<int>(FractionLimbs)));
+        return negative() ? -result : result;
+    }
+
+    std::string to_string(std::size_t fraction_digits = FractionLimbs * 32 * 3 / 10) const
+    {
+        FixedPoint absolute = magnitude();
+        std::string result = negative() ? "-" : "";
+        result += std::to_string(absolute.limbs[limb_count - 1]);
+        result += '.';
+        absolute.limbs[limb_count - 1] = 0;
+        for (std::size_t i = 0; i < fraction_digits; ++i)
+        {
+            std::uint64_t carry = 0;
+            for (std::size_t j = 0; j < limb_count; ++j)
+            {
+                carry += static_cast<std::uint64_t>(absolute.limbs[j]) * 10;
+                absolute.limbs[j] = static_cast<std::uint32_t>(carry);
+                carry >>= 32;
+            }
+            result += static_cast<char>('0' + absolute.limbs[limb_count - 1]);
+            absolute.limbs[limb_count - 1] = 0;
+        }
+        return result;
+    }
+
+    FixedPoint operator-() const noexcept {return negated();}
+
+    friend FixedPoint operator+(const FixedPoint& a, const FixedPoint& b) noexcept
+    {
+        FixedPoint result;
+        std::uint64_t carry = 0;
+        for (std::size_t i = 0; i < limb_count; ++i)
+        {
+            carry += static_cast<std::uint64_t>(a.limbs[i]) + b.limbs[i];
+            result.limbs[i] = static_cast<std::uint32_t>(carry);
+            carry >>= 32;
+        }
+        return result;
+    }
+
+    friend FixedPoint operator-(const FixedPoint& a, const FixedPoint& b) noexcept {return a + b.negated();}
+
+    friend FixedPoint operator*(const FixedPoint& a, const FixedPoint& b) noexcept
+    {
+        const FixedPoint x = a.magnitude();
+        const FixedPoint y = b.magnitude();
+
+        std::array<std::uint32_t, limb_count * 2> product{};
+        for (std::size_t i = 0; i < limb_count; ++i)
+        {
+            std::uint64_t carry = 0;
+            for (std::size_t j = 0; j < limb_count; ++j)
+            {
+                carry += static_cast<std::uint64_t>(x.limbs[i]) * y.limbs[j] + product[i + j];
+                product[i + j] = static_cast<std::uint32_t>(carry);
+                carry >>= 32;
+            }
+            product[i + limb_count] = static_cast<std::uint32_t>(carry);
+        }
+
+        FixedPoint result;
+        for (std::size_t i = 0; i < limb_count; ++i)
+            result.limbs[i] = product[i + FractionLimbs];
+
+        return a.negative() != b.negative() ? result.negated() : result;
+    }
+
+    friend bool operator==(const FixedPoint& a, const FixedPoint& b) noexcept {return a.limbs == b.limbs;}
+    friend bool operator!=(const FixedPoint& a, const FixedPoint& b) noexcept {return a.limbs != b.limbs;}
+};
+
+// 256 fractional bits: enough for view centres down to ~1e-70.
+using HighPrecision = FixedPoint<8>;
+
+#endif
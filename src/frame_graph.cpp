@@ -0,0 +1,56 @@
+#include "frame_graph.hpp"
+
+#include <GL/glew.h>
+
+#include <algorithm>
+
+namespace
+{
+    constexpr GLint MARGIN = 8;
+    constexpr GLint HEIGHT = 100;
+    constexpr double PIXELS_PER_MILLISECOND = HEIGHT / 33.3;   // the full height is two 60 Hz frames
+
+    void fill(GLint x, GLint y, GLsizei width, GLsizei height, GLfloat red, GLfloat green, GLfloat blue)
+    {
+        if (width <= 0 || height <= 0)
+            return;
+
+        ::glScissor(x, y, width, height);
+        ::glClearColor(red, green, blue, 1.0F);
+        ::glClear(GL_COLOR_BUFFER_BIT);
+    }
+
+    GLsizei bar_height(double milliseconds) noexcept
+    {
+        return static_cast<GLsizei>(std::min(milliseconds * PIXELS_PER_MILLISECOND, static_cast<double>(HEIGHT)));
+    }
+}
+
+void FrameGraph::add(double cpu_milliseconds, double gpu_milliseconds) noexcept
+{
+    cpu_times[next] = cpu_milliseconds;
+    gpu_times[next] = gpu_milliseconds;
+    next = (next + 1) % SIZE;
+}
+
+void FrameGraph::draw() const
+{
+    ::glEnable(GL_SCISSOR_TEST);
+
+    ::fill(MARGIN, MARGIN, static_cast<GLsizei>(SIZE * 2), HEIGHT, 0.1F, 0.1F, 0.1F);
+
+    for (std::size_t age = 0; age < SIZE; ++age)
+    {
+        const std::size_t sample = (next + age) % SIZE;     // oldest on the left
+        const GLint x = MARGIN + static_cast<GLint>(age * 2);
+
+        ::fill(x,     MARGIN, 1, ::bar_height(cpu_times[sample]), 0.2F, 0.5F, 1.0F);
+        ::fill(x + 1, MARGIN, 1, ::bar_height(gpu_times[sample]), 1.0F, 0.6F, 0.1F);
+    }
+
+    // 60 Hz budget
+    ::fill(MARGIN, MARGIN + ::bar_height(1000.0 / 60.0), static_cast<GLsizei>(SIZE * 2), 1, 1.0F, 1.0F, 1.0F);
+
+    ::glDisable(GL_SCISSOR_TEST);
+    ::glClearColor(0.0F, 0.0F, 0.0F, 1.0F);
+}
@@ -0,0 +1,23 @@
+#ifndef FRAME_GRAPH_HPP
+#define FRAME_GRAPH_HPP
+
+#include <array>
+#include <cstddef>
+
+// Bar graph of recent CPU and GPU frame times in the lower left corner of the window. It is drawn
+// with scissored clears, so it needs neither a shader nor a font.
+class FrameGraph
+{
+    static constexpr std::size_t SIZE = 120;
+
+    std::array<double, SIZE> cpu_times{};
+    std::array<double, SIZE> gpu_times{};
+    std::size_t next = 0;
+
+public:
+    void add(double cpu_milliseconds, double gpu_milliseconds) noexcept;
+    // Leaves the scissor test disabled and the clear color black.
+    void draw() const;
+};
+
+#endif
@@ -0,0 +1,41 @@
+#include "frame_pacer.hpp"
+
+#include <algorithm>
+#include <thread>
+
+namespace
+{
+    // covers scheduler wake-up jitter and the swap itself
+    constexpr double SAFETY_MARGIN = 0.002;
+}
+
+FramePacer::FramePacer(double period) : period{period}, last_present{clock::now()}
+{
+}
+
+double FramePacer::predicted_work() const noexcept
+{
+    return *std::max_element(work_times.begin(), work_times.end()) + SAFETY_MARGIN;
+}
+
+void FramePacer::wait() const
+{
+    if (period <= 0.0)
+        return;
+
+    const double delay = period - predicted_work();
+    if (delay <= 0.0)
+        return;
+
+    const clock::time_point start = last_present + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>{delay});
+    if (start > clock::now())
+        std::this_thread::sleep_until(start);
+}
+
+void FramePacer::presented(double work)
+{
+    work_times[next] = work;
+    next = (next + 1) % HISTORY;
+
+    last_present = clock::now();
+}
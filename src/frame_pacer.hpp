@@ -0,0 +1,34 @@
+#ifndef FRAME_PACER_HPP
+#define FRAME_PACER_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+// Delays the start of each frame so that input is polled as late as possible: the frame is expected
+// to take as long as the slowest of the recent ones, plus a margin, and is started just early enough
+// to be presented one period after the previous one.
+class FramePacer
+{
+    using clock = std::chrono::steady_clock;
+
+    static constexpr std::size_t HISTORY = 30;
+
+    double period;      // seconds, 0 disables pacing
+    std::array<double, HISTORY> work_times{};
+    std::size_t next = 0;
+    clock::time_point last_present;
+
+public:
+    explicit FramePacer(double period);
+
+    // Sleeps until the latest safe start of the next frame.
+    void wait() const;
+    // work is the time in seconds from the start of the frame until it was handed to the swap,
+    // including GPU time where known.
+    void presented(double work);
+
+    double predicted_work() const noexcept;
+};
+
+#endif
@@ -0,0 +1,243 @@
+#include "gl_resources.hpp"
+
+#include <stdexcept>
+#include <fstream>
+#include <iterator>
+
+GLvertex_array create_vertex_array_object()
+{
+    return GLvertex_array
+    {
+        []
+        {
+            GLuint vertex_array_object;
+            ::glCreateVertexArrays(1, &vertex_array_object);
+
+            if (!vertex_array_object)
+                throw std::runtime_error{"vertex array object creation error"};
+
+            return vertex_array_object;
+        }()
+    };
+}
+
+GLtexture create_iteration_texture(int width, int height)
+{
+    GLtexture texture
+    {
+        []
+        {
+            GLuint texture;
+            ::glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+
+            if (!texture)
+                throw std::runtime_error{"texture creation error"};
+
+            return texture;
+        }()
+    };
+
+    ::glTextureStorage2D(texture, 1, GL_R32UI, width, height);
+    ::glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    ::glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    return texture;
+}
+
+GLtexture create_palette_texture(GLsizei size, const GLfloat* rgb)
+{
+    GLtexture texture
+    {
+        []
+        {
+            GLuint texture;
+            ::glCreateTextures(GL_TEXTURE_1D, 1, &texture);
+
+            if (!texture)
+                throw std::runtime_error{"texture creation error"};
+
+            return texture;
+        }()
+    };
+
+    ::glTextureStorage1D(texture, 1, GL_RGB8, size);
+    ::glTextureSubImage1D(texture, 0, 0, size, GL_RGB, GL_FLOAT, rgb);
+    ::glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    ::glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    ::glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_REPEAT);
+
+    return texture;
+}
+
+GLframebuffer create_framebuffer()
+{
+    return GLframebuffer
+    {
+        []
+        {
+            GLuint framebuffer;
+            ::glCreateFramebuffers(1, &framebuffer);
+
+            if (!framebuffer)
+                throw std::runtime_error{"framebuffer creation error"};
+
+            return framebuffer;
+        }()
+    };
+}
+
+GLbuffer create_storage_buffer(GLsizeiptr size)
+{
+    GLbuffer buffer
+    {
+        []
+        {
+            GLuint buffer;
+            ::glCreateBuffers(1, &buffer);
+
+            if (!buffer)
+                throw std::runtime_error{"buffer creation error"};
+
+            return buffer;
+        }()
+    };
+
+    ::glNamedBufferData(buffer, size, nullptr, GL_DYNAMIC_READ);
+
+    return buffer;
+}
+
+GLbuffer create_uniform_buffer(GLsizeiptr size)
+{
+    GLbuffer buffer
+    {
+        []
+        {
+            GLuint buffer;
+            ::glCreateBuffers(1, &buffer);
+
+            if (!buffer)
+                throw std::runtime_error{"buffer creation error"};
+
+            return buffer;
+        }()
+    };
+
+    ::glNamedBufferStorage(buffer, size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    return buffer;
+}
+
+GLbuffer create_readback_buffer(GLsizeiptr size)
+{
+    GLbuffer buffer
+    {
+        []
+        {
+            GLuint buffer;
+            ::glCreateBuffers(1, &buffer);
+
+            if (!buffer)
+                throw std::runtime_error{"buffer creation error"};
+
+            return buffer;
+        }()
+    };
+
+    ::glNamedBufferStorage(buffer, size, nullptr, GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT |
+                                                  GL_CLIENT_STORAGE_BIT);
+
+    return buffer;
+}
+
+GLquery create_query(GLenum target)
+{
+    return GLquery
+    {
+        [target]
+        {
+            GLuint query;
+            ::glCreateQueries(target, 1, &query);
+
+            if (!query)
+                throw std::runtime_error{"query creation error"};
+
+            return query;
+        }()
+    };
+}
+
+GLshader create_shader(const std::string& source, GLenum shader_type)
+{
+    GLshader shader{::glCreateShader(shader_type)};
+    if (!shader)
+        throw std::runtime_error{"shader creation error"};
+
+    const char* const source_cstr = source.c_str();
+    ::glShaderSource(shader, 1, &source_cstr, nullptr);
+    ::glCompileShader(shader);
+    
+    GLint status;
+    ::glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (status == GL_FALSE)
+        throw std::runtime_error{"shader compilation error"};
+
+    return shader;
+}
+
+GLprogram create_shader_program(const std::string& vertex_shader_source, const std::string& fragment_shader_source,
+                                bool retrievable)
+{
+    GLprogram shader_program{::glCreateProgram()};
+    if (!shader_program)
+        throw std::runtime_error{"shader program creation error"};
+
+    const GLshader vertex_shader{::create_shader(vertex_shader_source, GL_VERTEX_SHADER)};
+    const GLshader fragment_shader{::create_shader(fragment_shader_source, GL_FRAGMENT_SHADER)};
+
+    ::glAttachShader(shader_program, vertex_shader);
+    ::glAttachShader(shader_program, fragment_shader);
+    if (retrievable)
+        ::glProgramParameteri(shader_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    ::glLinkProgram(shader_program);
+
+    GLint status;
+    ::glGetProgramiv(shader_program, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE)
+        throw std::runtime_error{"failed to link shader program"};
+
+    ::glDetachShader(shader_program, vertex_shader);
+    ::glDetachShader(shader_program, fragment_shader);
+
+    return shader_program;
+}
+
+GLprogram create_compute_program(const std::string& compute_shader_source)
+{
+    GLprogram shader_program{::glCreateProgram()};
+    if (!shader_program)
+        throw std::runtime_error{"shader program creation error"};
+
+    const GLshader compute_shader{::create_shader(compute_shader_source, GL_COMPUTE_SHADER)};
+
+    ::glAttachShader(shader_program, compute_shader);
+    ::glLinkProgram(shader_program);
+
+    GLint status;
+    ::glGetProgramiv(shader_program, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE)
+        throw std::runtime_error{"failed to link shader program"};
+
+    ::glDetachShader(shader_program, compute_shader);
+
+    return shader_program;
+}
+
+std::string read_file(const std::string& file_path)
+{
+    std::ifstream stream{file_path, std::ios::in};
+    if (!stream)
+        throw std::runtime_error{"file reading error"};
+
+    return {std::istreambuf_iterator<char>{stream}, std::istreambuf_iterator<char>{}};
+}
@@ -0,0 +1,81 @@
+#ifndef GL_RESOURCES_HPP
+#define GL_RESOURCES_HPP
+
+#include <GL/glew.h>
+
+#include <string>
+#include <utility>
+
+// Owning handle of one GL object. Kind supplies the matching delete call, so each kind of object is
+// its own type, handles of different kinds cannot be mixed up, and destruction is a direct call.
+template <typename Kind>
+class GLobject
+{
+    GLuint index = 0;
+
+public:
+    GLobject() noexcept = default;
+    explicit GLobject(GLuint index) noexcept : index{index} {}
+    GLobject(const GLobject&) = delete;
+    GLobject(GLobject&& globject) noexcept : index{globject.index}
+    {
+        globject.index = 0;
+    }
+    ~GLobject()
+    {
+        if (index)
+            Kind::destroy(index);
+    }
+
+    GLobject& operator=(const GLobject&) = delete;
+
+    // the previous object goes with globject
+    GLobject& operator=(GLobject&& globject) noexcept
+    {
+        std::swap(index, globject.index);
+        return *this;
+    }
+
+    operator GLuint() const noexcept {return index;}
+};
+
+struct BufferKind       {static void destroy(GLuint buffer) noexcept             {::glDeleteBuffers(1, &buffer);}};
+struct TextureKind      {static void destroy(GLuint texture) noexcept            {::glDeleteTextures(1, &texture);}};
+struct FramebufferKind  {static void destroy(GLuint framebuffer) noexcept        {::glDeleteFramebuffers(1, &framebuffer);}};
+struct VertexArrayKind  {static void destroy(GLuint vertex_array_object) noexcept{::glDeleteVertexArrays(1, &vertex_array_object);}};
+struct QueryKind        {static void destroy(GLuint query) noexcept              {::glDeleteQueries(1, &query);}};
+struct ShaderKind       {static void destroy(GLuint shader) noexcept             {::glDeleteShader(shader);}};
+struct ProgramKind      {static void destroy(GLuint program) noexcept            {::glDeleteProgram(program);}};
+
+using GLbuffer       = GLobject<BufferKind>;
+using GLtexture      = GLobject<TextureKind>;
+using GLframebuffer  = GLobject<FramebufferKind>;
+using GLvertex_array = GLobject<VertexArrayKind>;
+using GLquery        = GLobject<QueryKind>;
+using GLshader       = GLobject<ShaderKind>;
+using GLprogram      = GLobject<ProgramKind>;
+
+// All objects are made with the glCreate* calls of direct state access, so they exist, with their
+// final target, before they are first bound.
+
+// Without attributes, for shaders that make their vertices from gl_VertexID.
+GLvertex_array create_vertex_array_object();
+GLtexture create_iteration_texture(int width, int height);
+// Linear filtering and repeat wrapping, from size tightly packed RGB float colors.
+GLtexture create_palette_texture(GLsizei size, const GLfloat* rgb);
+GLframebuffer create_framebuffer();
+GLbuffer create_storage_buffer(GLsizeiptr size);
+// Immutable storage, updated with glNamedBufferSubData().
+GLbuffer create_uniform_buffer(GLsizeiptr size);
+// Immutable storage for persistently mapped reads, see ReadbackRing.
+GLbuffer create_readback_buffer(GLsizeiptr size);
+GLquery create_query(GLenum target);
+GLshader create_shader(const std::string& source, GLenum shader_type);
+// retrievable asks the driver to keep the linked binary for glGetProgramBinary().
+GLprogram create_shader_program(const std::string& vertex_shader_source, const std::string& fragment_shader_source,
+                                bool retrievable = false);
+GLprogram create_compute_program(const std::string& compute_shader_source);
+
+std::string read_file(const std::string& file_path);
+
+#endif
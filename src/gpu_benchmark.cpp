@@ -0,0 +1,92 @@
+#include "gpu_benchmark.hpp"
+#include "tile_pyramid.hpp"
+#include "trace.hpp"
+
+#include <vector>
+#include <stdexcept>
+#include <cstdint>
+
+namespace
+{
+    // as in mandelbrot_shader.fs
+    constexpr std::uint32_t SKIPPED = 0x80000000U;
+    constexpr std::uint32_t INTERIOR = 0x40000000U;
+    constexpr unsigned FRACTION_BITS = 8;
+}
+
+GpuBenchmark::GpuBenchmark(GLuint fp32_program, GLuint fp64_program) :
+    fp32_program{fp32_program}, fp64_program{fp64_program}, vertex_array_object{::create_vertex_array_object()},
+    framebuffer{::create_framebuffer()}, view_buffer{::create_uniform_buffer(sizeof(TilePyramid::ViewParameters))},
+    elapsed{::create_query(GL_TIME_ELAPSED)}
+{
+}
+
+BenchmarkRun GpuBenchmark::render(const Viewport& viewport, unsigned max_iterations, Precision precision)
+{
+    const TraceScope trace{"gpu_benchmark_render"};
+
+    if (precision == Precision::perturbation)
+        throw std::runtime_error{"the iteration shader has no perturbation"};
+
+    if (viewport.width != width || viewport.height != height)
+    {
+        texture = ::create_iteration_texture(viewport.width, viewport.height);
+        width = viewport.width;
+        height = viewport.height;
+
+        ::glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT0, texture, 0);
+        if (::glCheckNamedFramebufferStatus(framebuffer, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            throw std::runtime_error{"incomplete framebuffer"};
+    }
+
+    const double center_x = viewport.center_x.to_double();
+    const double center_y = viewport.center_y.to_double();
+    const double half_w = 0.5 * viewport.width  * viewport.pixel_size;
+    const double half_h = 0.5 * viewport.height * viewport.pixel_size;
+
+    TilePyramid::ViewParameters parameters{};
+    parameters.area_w[0] = static_cast<GLfloat>(center_x - half_w);
+    parameters.area_w[1] = static_cast<GLfloat>(center_x + half_w);
+    parameters.area_h[0] = static_cast<GLfloat>(center_y - half_h);
+    parameters.area_h[1] = static_cast<GLfloat>(center_y + half_h);
+    parameters.precise_area_w[0] = center_x - half_w;
+    parameters.precise_area_w[1] = center_x + half_w;
+    parameters.precise_area_h[0] = center_y - half_h;
+    parameters.precise_area_h[1] = center_y + half_h;
+    parameters.target_size[0] = static_cast<GLfloat>(viewport.width);
+    parameters.target_size[1] = static_cast<GLfloat>(viewport.height);
+    parameters.max_iterations = max_iterations;
+    ::glNamedBufferSubData(view_buffer, 0, sizeof(parameters), &parameters);
+
+    ::glBindBufferBase(GL_UNIFORM_BUFFER, TilePyramid::VIEW_BINDING, view_buffer);
+    ::glBindVertexArray(vertex_array_object);
+    ::glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    ::glViewport(0, 0, viewport.width, viewport.height);
+    ::glUseProgram(precision == Precision::fp32 ? fp32_program : fp64_program);
+
+    ::glBeginQuery(GL_TIME_ELAPSED, elapsed);
+    ::glDrawArrays(GL_TRIANGLES, 0, 3);
+    ::glEndQuery(GL_TIME_ELAPSED);
+
+    ::glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // waits for the draw
+    GLuint64 nanoseconds = 0;
+    ::glGetQueryObjectui64v(elapsed, GL_QUERY_RESULT, &nanoseconds);
+
+    std::vector<std::uint32_t> pixels(static_cast<std::size_t>(viewport.width) * viewport.height);
+    ::glGetTextureImage(texture, 0, GL_RED_INTEGER, GL_UNSIGNED_INT,
+                        static_cast<GLsizei>(pixels.size() * sizeof(std::uint32_t)), pixels.data());
+
+    // pixels the shader resolved without iterating count max_iterations each, as skipped
+    BenchmarkRun run{nanoseconds * 1e-9, 0, 0};
+    for (const std::uint32_t pixel : pixels)
+    {
+        if (pixel & SKIPPED)
+            run.skipped_iterations += max_iterations;
+        else
+            run.iterations += (pixel & ~(SKIPPED | INTERIOR)) >> FRACTION_BITS;
+    }
+
+    return run;
+}
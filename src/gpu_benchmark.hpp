@@ -0,0 +1,31 @@
+#ifndef GPU_BENCHMARK_HPP
+#define GPU_BENCHMARK_HPP
+
+#include "gl_resources.hpp"
+#include "benchmark.hpp"
+
+// The benchmark's GPU backend: runs the viewer's iteration shader over a whole viewport in one draw
+// into a texture of its own, times the draw alone with a GL_TIME_ELAPSED query, and reads the counts
+// back to total the iterations. Needs a current context, the one of a hidden window will do.
+class GpuBenchmark
+{
+    GLuint fp32_program;
+    GLuint fp64_program;
+
+    GLvertex_array vertex_array_object;
+    GLframebuffer framebuffer;
+    GLbuffer view_buffer;
+    GLquery elapsed;
+    GLtexture texture;
+    int width = 0;
+    int height = 0;
+
+public:
+    // The plain Mandelbrot permutations of the iteration shader, without and with DOUBLE_PRECISION.
+    GpuBenchmark(GLuint fp32_program, GLuint fp64_program);
+
+    // fp32 and fp64 only.
+    BenchmarkRun render(const Viewport& viewport, unsigned max_iterations, Precision precision);
+};
+
+#endif
@@ -0,0 +1,104 @@
+#include "gpu_timer.hpp"
+
+#include <stdexcept>
+
+void RollingAverage::add(double sample) noexcept
+{
+    if (count == SIZE)
+        sum -= samples[next];
+    else
+        ++count;
+
+    samples[next] = sample;
+    sum += sample;
+    next = (next + 1) % SIZE;
+}
+
+GpuTimer::GpuTimer(std::size_t pass_count, std::size_t ring_size) : pass_times(pass_count)
+{
+    if (!pass_count || !ring_size)
+        throw std::runtime_error{"gpu timer needs at least one pass and one slot"};
+
+    slots.resize(ring_size);
+    for (Slot& slot : slots)
+    {
+        for (std::size_t pass = 0; pass < pass_count; ++pass)
+            slot.queries.push_back(::create_query(GL_TIME_ELAPSED));
+        slot.issued.assign(pass_count, false);
+        slot.pending = false;
+    }
+}
+
+bool GpuTimer::collect(Slot& slot)
+{
+    for (std::size_t pass = 0; pass < slot.queries.size(); ++pass)
+    {
+        GLint available = GL_TRUE;
+        if (slot.issued[pass])
+            ::glGetQueryObjectiv(slot.queries[pass], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            return false;
+    }
+
+    double total = 0.0;
+    for (std::size_t pass = 0; pass < slot.queries.size(); ++pass)
+    {
+        GLuint64 elapsed = 0;
+        if (slot.issued[pass])
+            ::glGetQueryObjectui64v(slot.queries[pass], GL_QUERY_RESULT, &elapsed);
+
+        const double milliseconds = elapsed * 1e-6;
+        pass_times[pass].add(milliseconds);
+        total += milliseconds;
+    }
+
+    frame_time.add(total);
+    last_frame = total;
+    slot.pending = false;
+
+    return true;
+}
+
+void GpuTimer::begin_frame()
+{
+    // oldest first, so the averages see frames in order
+    for (std::size_t offset = 1; offset <= slots.size(); ++offset)
+    {
+        Slot& slot = slots[(current + offset) % slots.size()];
+        if (slot.pending && !collect(slot))
+            break;
+    }
+
+    current = (current + 1) % slots.size();
+    Slot& slot = slots[current];
+
+    timing = !slot.pending;
+    if (timing)
+    {
+        slot.issued.assign(slot.issued.size(), false);
+        slot.pending = true;
+    }
+}
+
+void GpuTimer::begin(std::size_t pass)
+{
+    if (!timing || active)
+        return;
+
+    Slot& slot = slots[current];
+    if (slot.issued[pass])
+        return;
+
+    ::glBeginQuery(GL_TIME_ELAPSED, slot.queries[pass]);
+    slot.issued[pass] = true;
+    active = true;
+}
+
+void GpuTimer::end()
+{
+    if (!active)
+        return;
+
+    ::glEndQuery(GL_TIME_ELAPSED);
+    active = false;
+}
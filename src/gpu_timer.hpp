@@ -0,0 +1,66 @@
+#ifndef GPU_TIMER_HPP
+#define GPU_TIMER_HPP
+
+#include "gl_resources.hpp"
+
+#include <vector>
+#include <array>
+#include <cstddef>
+
+// Mean of the most recent samples.
+class RollingAverage
+{
+    static constexpr std::size_t SIZE = 60;
+
+    std::array<double, SIZE> samples{};
+    std::size_t count = 0;
+    std::size_t next = 0;
+    double sum = 0.0;
+
+public:
+    void add(double sample) noexcept;
+
+    double mean() const noexcept {return count ? sum / count : 0.0;}
+};
+
+// GL_TIME_ELAPSED queries around a fixed set of render passes. Every frame records into its own slot
+// of a ring; slots are read back frames later, once the GPU has finished them. A frame whose slot is
+// still in flight goes untimed, so the CPU never waits for a result.
+class GpuTimer
+{
+    struct Slot
+    {
+        std::vector<GLquery> queries;  // one per pass
+        std::vector<bool> issued;
+        bool pending;
+    };
+
+    std::vector<Slot> slots;
+    std::size_t current = 0;
+    bool timing = false;
+    bool active = false;
+
+    std::vector<RollingAverage> pass_times;
+    RollingAverage frame_time;
+    double last_frame = 0.0;
+
+    bool collect(Slot& slot);
+
+public:
+    GpuTimer(std::size_t pass_count, std::size_t ring_size = 4);
+
+    // Reads back finished slots and selects the slot for the new frame.
+    void begin_frame();
+
+    // Passes must not overlap; each is timed at most once per frame.
+    void begin(std::size_t pass);
+    void end();
+
+    // Milliseconds, averaged over recent timed frames.
+    double pass_milliseconds(std::size_t pass) const noexcept {return pass_times[pass].mean();}
+    double frame_milliseconds() const noexcept {return frame_time.mean();}
+    // Milliseconds of the most recently read back frame.
+    double last_frame_milliseconds() const noexcept {return last_frame;}
+};
+
+#endif
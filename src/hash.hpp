@@ -0,0 +1,20 @@
+#ifndef HASH_HPP
+#define HASH_HPP
+
+#include <string>
+#include <cstdint>
+
+// 64-bit FNV-1a: fast and stable across runs and builds, for file names and cache keys rather than
+// hash tables.
+inline std::uint64_t fnv1a(const std::string& data) noexcept
+{
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const char c : data)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+#endif
@@ -0,0 +1,34 @@
+#include "histogram_equalizer.hpp"
+#include "trace.hpp"
+
+#include <vector>
+#include <utility>
+
+HistogramEqualizer::HistogramEqualizer(GLprogram program) :
+    program{std::move(program)},
+    histograms{::create_storage_buffer(LOCAL_HISTOGRAMS * BIN_COUNT * sizeof(GLuint))},
+    cdf{::create_storage_buffer(BIN_COUNT * sizeof(GLfloat))}
+{
+    ::glClearNamedBufferData(histograms, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+    std::vector<GLfloat> linear(BIN_COUNT);
+    for (GLuint bin = 0; bin < BIN_COUNT; ++bin)
+        linear[bin] = static_cast<GLfloat>(bin + 1) / BIN_COUNT;
+    ::glNamedBufferSubData(cdf, 0, BIN_COUNT * sizeof(GLfloat), linear.data());
+
+    ::glBindBufferBase(GL_SHADER_STORAGE_BUFFER, HISTOGRAM_BINDING, histograms);
+    ::glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CDF_BINDING, cdf);
+}
+
+void HistogramEqualizer::update(GLuint resume_program)
+{
+    const TraceScope trace{"equalize_histogram"};
+
+    // the color pass's atomic counts, and the next color pass's CDF reads, around the scan
+    ::glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    ::glUseProgram(program);
+    ::glDispatchCompute(1, 1, 1);
+    ::glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    ::glUseProgram(resume_program);
+}
@@ -0,0 +1,31 @@
+#ifndef HISTOGRAM_EQUALIZER_HPP
+#define HISTOGRAM_EQUALIZER_HPP
+
+#include "gl_resources.hpp"
+
+// Histogram equalization of the color pass, one frame behind: while drawing, color_shader.fs counts
+// the smooth iteration counts of escaped pixels into local histograms picked by pixel position and
+// colors through the CDF of the previous frame. A single compute workgroup then sums the local
+// histograms bin by bin, clears them, and prefix-sums the totals into the CDF for the next frame.
+class HistogramEqualizer
+{
+    GLprogram program;
+    GLbuffer histograms;
+    GLbuffer cdf;
+
+public:
+    // must match equalize_shader.comp and color_shader.fs
+    static constexpr GLuint HISTOGRAM_BINDING = 1;
+    static constexpr GLuint CDF_BINDING = 2;
+    static constexpr GLuint BIN_COUNT = 1024;
+    static constexpr GLuint LOCAL_HISTOGRAMS = 16;
+
+    // Binds both buffers for good; the CDF starts out linear, the plain smooth coloring.
+    explicit HistogramEqualizer(GLprogram program);
+
+    // After a color pass drawn with equalization: turns its histograms into the next frame's CDF.
+    // Leaves resume_program in use, for callers that skip redundant glUseProgram() calls.
+    void update(GLuint resume_program);
+};
+
+#endif
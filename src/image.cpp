@@ -0,0 +1,182 @@
+#include "image.hpp"
+#include "palette.hpp"
+
+#include <zlib.h>
+
+#include <fstream>
+#include <stdexcept>
+#include <algorithm>
+#include <thread>
+
+namespace
+{
+    // as HistogramEqualizer::BIN_COUNT, so that both backends equalize alike and memory does not grow
+    // with max_iterations
+    constexpr std::size_t EQUALIZE_BINS = 1024;
+
+    void append_u32(std::string& output, std::uint32_t value)
+    {
+        for (int shift = 24; shift >= 0; shift -= 8)
+            output += static_cast<char>((value >> shift) & 0xFF);
+    }
+
+    void append_png_chunk(std::string& output, const char* type, const std::string& data)
+    {
+        ::append_u32(output, static_cast<std::uint32_t>(data.size()));
+
+        const std::size_t start = output.size();
+        output.append(type, 4);
+        output += data;
+
+        const auto* const bytes = reinterpret_cast<const Bytef*>(output.data() + start);
+        ::append_u32(output, static_cast<std::uint32_t>(::crc32(0, bytes, static_cast<uInt>(output.size() - start))));
+    }
+}
+
+std::vector<std::uint8_t> colorize(const IterationBuffer& buffer, unsigned max_iterations)
+{
+    std::vector<std::uint8_t> rgb(buffer.iterations.size() * 3);
+    const Palette palette{::default_palette()};
+
+    for (std::size_t i = 0; i < buffer.iterations.size(); ++i)
+    {
+        const std::uint32_t iteration = buffer.iterations[i];
+        if (iteration >= max_iterations)
+            continue;
+
+        const std::array<float, 3>& color = palette[iteration * 100ULL / max_iterations % palette.size()];
+        for (std::size_t channel = 0; channel < 3; ++channel)
+            rgb[i * 3 + channel] = static_cast<std::uint8_t>(color[channel] * 255.0F + 0.5F);
+    }
+
+    return rgb;
+}
+
+std::vector<std::uint8_t> colorize_equalized(const IterationBuffer& buffer, unsigned max_iterations, unsigned thread_count)
+{
+    const unsigned limit = thread_count ? thread_count : std::max(1U, std::thread::hardware_concurrency());
+    const int block_count = std::max(1, std::min(buffer.height, static_cast<int>(limit)));
+    const auto block_rows = [&](int block) {return static_cast<std::size_t>(buffer.height) * block / block_count;};
+
+    const auto bin_position = [max_iterations](std::uint32_t iteration)
+    {
+        return static_cast<double>(iteration) / max_iterations * EQUALIZE_BINS;
+    };
+    const auto bin_of = [&bin_position](std::uint32_t iteration)
+    {
+        return std::min(static_cast<std::size_t>(bin_position(iteration)), EQUALIZE_BINS - 1);
+    };
+
+    // one local histogram per block of rows, so the threads never share a counter
+    std::vector<std::vector<std::uint64_t>> histograms(block_count, std::vector<std::uint64_t>(EQUALIZE_BINS));
+    ::parallel_for(block_count, thread_count, [&](int block)
+    {
+        std::vector<std::uint64_t>& histogram = histograms[block];
+        const std::size_t end = block_rows(block + 1) * buffer.width;
+        for (std::size_t i = block_rows(block) * buffer.width; i < end; ++i)
+            if (buffer.iterations[i] < max_iterations)
+                ++histogram[bin_of(buffer.iterations[i])];
+    });
+
+    // reduction and prefix sum: cdf[bin] is the share of escaped pixels up to and including the bin
+    std::vector<double> cdf(EQUALIZE_BINS);
+    std::uint64_t total = 0;
+    for (std::size_t bin = 0; bin < EQUALIZE_BINS; ++bin)
+    {
+        for (const auto& histogram : histograms)
+            total += histogram[bin];
+        cdf[bin] = static_cast<double>(total);
+    }
+    for (double& share : cdf)
+        share /= std::max<std::uint64_t>(total, 1);
+
+    std::vector<std::uint8_t> rgb(buffer.iterations.size() * 3);
+    const Palette palette{::default_palette()};
+
+    ::parallel_for(buffer.height, thread_count, [&](int row)
+    {
+        const std::size_t begin = static_cast<std::size_t>(row) * buffer.width;
+        for (std::size_t i = begin; i < begin + buffer.width; ++i)
+        {
+            const std::uint32_t iteration = buffer.iterations[i];
+            if (iteration >= max_iterations)
+                continue;
+
+            // linear within the bin, as color_shader.fs does
+            const std::size_t bin = bin_of(iteration);
+            const double below = bin ? cdf[bin - 1] : 0.0;
+            const double share = below + (cdf[bin] - below) * (bin_position(iteration) - bin);
+
+            const std::array<float, 3>& color = palette[static_cast<std::size_t>(share * 100.0) % palette.size()];
+            for (std::size_t channel = 0; channel < 3; ++channel)
+                rgb[i * 3 + channel] = static_cast<std::uint8_t>(color[channel] * 255.0F + 0.5F);
+        }
+    });
+
+    return rgb;
+}
+
+std::vector<std::uint8_t> colorize_distance(const DistanceEstimate& estimate, unsigned max_iterations)
+{
+    std::vector<std::uint8_t> rgb{::colorize(estimate.buffer, max_iterations)};
+
+    for (std::size_t i = 0; i < estimate.distances.size(); ++i)
+    {
+        const float t = std::min(estimate.distances[i], 1.0F);
+        const float shade = t * t * (3.0F - 2.0F * t);  // smoothstep, as in color_shader.fs
+
+        for (std::size_t channel = 0; channel < 3; ++channel)
+            rgb[i * 3 + channel] = static_cast<std::uint8_t>(rgb[i * 3 + channel] * shade + 0.5F);
+    }
+
+    return rgb;
+}
+
+std::string encode_png(int width, int height, const std::vector<std::uint8_t>& rgb)
+{
+    const std::size_t stride = static_cast<std::size_t>(width) * 3;
+
+    std::string raw;
+    raw.reserve((stride + 1) * height);
+    for (int row = 0; row < height; ++row)
+    {
+        raw += '\0';   // filter type: none
+        raw.append(reinterpret_cast<const char*>(&rgb[row * stride]), stride);
+    }
+
+    uLongf compressed_size = ::compressBound(static_cast<uLong>(raw.size()));
+    std::string compressed(compressed_size, '\0');
+    if (::compress2(reinterpret_cast<Bytef*>(&compressed[0]), &compressed_size,
+                    reinterpret_cast<const Bytef*>(raw.data()), static_cast<uLong>(raw.size()), Z_BEST_SPEED) != Z_OK)
+        throw std::runtime_error{"png compression error"};
+    compressed.resize(compressed_size);
+
+    std::string header;
+    ::append_u32(header, static_cast<std::uint32_t>(width));
+    ::append_u32(header, static_cast<std::uint32_t>(height));
+    header += std::string{"\x08\x02\x00\x00\x00", 5};   // 8-bit RGB, no interlace
+
+    std::string png{"\x89PNG\r\n\x1a\n", 8};
+    ::append_png_chunk(png, "IHDR", header);
+    ::append_png_chunk(png, "IDAT", compressed);
+    ::append_png_chunk(png, "IEND", {});
+
+    return png;
+}
+
+void write_rgb(std::ostream& stream, const std::vector<std::uint8_t>& rgb)
+{
+    stream.write(reinterpret_cast<const char*>(rgb.data()), static_cast<std::streamsize>(rgb.size()));
+    if (!stream)
+        throw std::runtime_error{"image writing error"};
+}
+
+void write_ppm(const std::string& file_path, int width, int height, const std::vector<std::uint8_t>& rgb)
+{
+    std::ofstream stream{file_path, std::ios::out | std::ios::binary};
+    if (!stream)
+        throw std::runtime_error{"file writing error: " + file_path};
+
+    stream << "P6\n" << width << ' ' << height << "\n255\n";
+    ::write_rgb(stream, rgb);
+}
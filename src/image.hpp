@@ -0,0 +1,26 @@
+#ifndef IMAGE_HPP
+#define IMAGE_HPP
+
+#include "kernel.hpp"
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <ostream>
+
+// The default palette in bands of max_iterations / 100 iterations: the viewer without smoothing.
+std::vector<std::uint8_t> colorize(const IterationBuffer& buffer, unsigned max_iterations);
+// The same 100 bands spread by histogram equalization, so each covers about as many escaped pixels as
+// the next one. The histogram has the viewer's 1024 bins over iteration / max_iterations, whatever
+// max_iterations is. thread_count 0 uses every hardware thread.
+std::vector<std::uint8_t> colorize_equalized(const IterationBuffer& buffer, unsigned max_iterations,
+                                             unsigned thread_count = 0);
+// The banded colors darkened within a pixel of the boundary, so thin filaments stay visible.
+std::vector<std::uint8_t> colorize_distance(const DistanceEstimate& estimate, unsigned max_iterations);
+
+std::string encode_png(int width, int height, const std::vector<std::uint8_t>& rgb);
+
+void write_rgb(std::ostream& stream, const std::vector<std::uint8_t>& rgb);
+void write_ppm(const std::string& file_path, int width, int height, const std::vector<std::uint8_t>& rgb);
+
+#endif
@@ -0,0 +1,65 @@
+#include "input_recording.hpp"
+
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+#include <limits>
+
+namespace
+{
+    const std::string HEADER = "# mandelbrotgl input recording 1";
+}
+
+InputRecorder::InputRecorder(const std::string& file_path) :
+    stream{file_path, std::ios::out | std::ios::trunc}, started{std::chrono::steady_clock::now()}
+{
+    if (!stream)
+        throw std::runtime_error{"cannot write " + file_path};
+
+    stream << HEADER << '\n' << std::setprecision(std::numeric_limits<double>::max_digits10);
+}
+
+void InputRecorder::record(const MandelbrotData& data)
+{
+    if (!empty && data == last)
+        return;
+
+    const double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    // flushed per line: a session is most interesting when it ends in a crash
+    stream << time << ' ' << data.scale << ' ' << data.x << ' ' << data.y << ' ' << data.max_iterations << std::endl;
+
+    last = data;
+    empty = false;
+}
+
+std::vector<RecordedInput> load_recording(const std::string& file_path)
+{
+    std::ifstream stream{file_path, std::ios::in};
+    if (!stream)
+        throw std::runtime_error{"cannot read " + file_path};
+
+    std::string line;
+    if (!std::getline(stream, line) || line != HEADER)
+        throw std::runtime_error{file_path + " is not an input recording"};
+
+    std::vector<RecordedInput> inputs;
+    for (unsigned number = 2; std::getline(stream, line); ++number)
+    {
+        if (line.empty())
+            continue;
+
+        std::istringstream fields{line};
+        RecordedInput input;
+        if (!(fields >> input.time >> input.data.scale >> input.data.x >> input.data.y >> input.data.max_iterations) ||
+            (!inputs.empty() && input.time < inputs.back().time))
+            throw std::runtime_error{file_path + ':' + std::to_string(number) + ": malformed input"};
+
+        inputs.push_back(input);
+    }
+
+    if (inputs.empty())
+        throw std::runtime_error{file_path + " contains no input"};
+
+    return inputs;
+}
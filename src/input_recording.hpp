@@ -0,0 +1,35 @@
+#ifndef INPUT_RECORDING_HPP
+#define INPUT_RECORDING_HPP
+
+#include "mandelbrot_data.hpp"
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <chrono>
+
+struct RecordedInput
+{
+    double time;    // seconds since the recording started
+    MandelbrotData data;
+};
+
+// Logs every change of the view state as a text line "<seconds> <scale> <x> <y> <max_iterations>",
+// with doubles written exactly, so a session can be replayed frame for frame.
+class InputRecorder
+{
+    std::ofstream stream;
+    std::chrono::steady_clock::time_point started;
+    MandelbrotData last{};
+    bool empty = true;
+
+public:
+    explicit InputRecorder(const std::string& file_path);
+
+    // Writes data only if it differs from the last recorded state.
+    void record(const MandelbrotData& data);
+};
+
+std::vector<RecordedInput> load_recording(const std::string& file_path);
+
+#endif
@@ -0,0 +1,95 @@
+#include "iteration_statistics.hpp"
+
+#include <vector>
+
+namespace
+{
+    // matches struct Counters in color_shader.fs
+    constexpr std::size_t COUNTERS = 8;
+
+    std::uint64_t wide(GLuint low, GLuint high) noexcept
+    {
+        return static_cast<std::uint64_t>(high) << 32 | low;
+    }
+    constexpr GLsizeiptr BUFFER_SIZE = IterationStatistics::BUCKET_COUNT * COUNTERS * sizeof(GLuint);
+}
+
+IterationStatistics::IterationStatistics() :
+    slots{{{::create_storage_buffer(BUFFER_SIZE), nullptr},
+           {::create_storage_buffer(BUFFER_SIZE), nullptr},
+           {::create_storage_buffer(BUFFER_SIZE), nullptr}}}
+{
+}
+
+IterationStatistics::~IterationStatistics()
+{
+    for (Slot& slot : slots)
+        if (slot.fence)
+            ::glDeleteSync(slot.fence);
+}
+
+void IterationStatistics::collect(Slot& slot)
+{
+    std::vector<GLuint> counters(BUCKET_COUNT * COUNTERS);
+
+    ::glGetNamedBufferSubData(slot.buffer, 0, BUFFER_SIZE, counters.data());
+
+    IterationTotals totals{};
+    for (std::size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket)
+    {
+        const GLuint* const counter = &counters[bucket * COUNTERS];
+
+        totals.iterations       += ::wide(counter[0], counter[1]);
+        totals.pixels           += counter[2];
+        totals.max_pixels       += counter[3];
+        totals.skipped_pixels   += counter[4];
+        totals.interior_pixels  += counter[5];
+        totals.saved_iterations += ::wide(counter[6], counter[7]);
+    }
+    latest = totals;
+
+    ::glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+}
+
+bool IterationStatistics::begin_frame()
+{
+    // oldest first, so latest ends up holding the most recent finished frame
+    for (std::size_t offset = 1; offset <= slots.size(); ++offset)
+    {
+        Slot& slot = slots[(current + offset) % slots.size()];
+        if (!slot.fence)
+            continue;
+
+        const GLenum status = ::glClientWaitSync(slot.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+
+        collect(slot);
+    }
+
+    current = (current + 1) % slots.size();
+    Slot& slot = slots[current];
+
+    collecting = !slot.fence;
+    if (collecting)
+    {
+        const GLuint zero = 0;
+        ::glClearNamedBufferData(slot.buffer, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+        ::glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING, slot.buffer);
+    }
+
+    return collecting;
+}
+
+void IterationStatistics::end_frame()
+{
+    if (!collecting)
+        return;
+
+    ::glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING, 0);
+    ::glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    slots[current].fence = ::glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    collecting = false;
+}
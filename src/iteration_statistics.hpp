@@ -0,0 +1,58 @@
+#ifndef ITERATION_STATISTICS_HPP
+#define ITERATION_STATISTICS_HPP
+
+#include "gl_resources.hpp"
+
+#include <array>
+#include <cstdint>
+
+struct IterationTotals
+{
+    std::uint64_t pixels;
+    std::uint64_t iterations;
+    std::uint64_t max_pixels;       // reached max_iterations, early-outs included
+    std::uint64_t skipped_pixels;   // resolved by an early-out without iterating
+    std::uint64_t interior_pixels;  // stopped early by interior detection
+    std::uint64_t saved_iterations; // that interior detection did not have to run
+};
+
+// Per-frame totals of the iteration counts shown on screen. The color pass adds into atomic
+// counters of a storage buffer, spread over buckets by pixel position to keep contention low; the
+// iteration sums outgrow 32 bits even so and are carried into a second word. The buckets are summed
+// on the CPU. Each frame writes its own buffer of a ring and is read back only once its fence has
+// signalled, so nothing waits on the GPU.
+class IterationStatistics
+{
+    struct Slot
+    {
+        GLbuffer buffer;
+        GLsync fence;
+    };
+
+    std::array<Slot, 3> slots;
+    std::size_t current = 0;
+    bool collecting = false;
+
+    IterationTotals latest{};
+
+    void collect(Slot& slot);
+
+public:
+    static constexpr GLuint BINDING = 0;
+    static constexpr std::size_t BUCKET_COUNT = 256;
+
+    IterationStatistics();
+    IterationStatistics(const IterationStatistics&) = delete;
+    ~IterationStatistics();
+
+    IterationStatistics& operator=(const IterationStatistics&) = delete;
+
+    // Reads back finished frames and, if a buffer is free, clears and binds it for this frame.
+    // Returns whether the color pass should count this frame.
+    bool begin_frame();
+    void end_frame();
+
+    const IterationTotals& get_latest() const noexcept {return latest;}
+};
+
+#endif
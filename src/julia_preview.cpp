@@ -0,0 +1,174 @@
+#include "julia_preview.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+    // of the window in each direction
+    constexpr int WINDOW_FRACTION = 3;
+    // across the shorter side: the Julia sets of z^2 + c lie within |z| <= 2
+    constexpr double EXTENT = 4.0;
+    // the coarsest render while the parameter moves, per direction
+    constexpr double MIN_SCALE = 0.125;
+    // weight of the newest render in the cost estimate; the cost changes with the parameter
+    constexpr double SMOOTHING = 0.5;
+    // inside the main cardioid, a connected set
+    constexpr double DEFAULT_PARAMETER[2] = {-0.8, 0.156};
+}
+
+JuliaPreview::JuliaPreview(int window_width, int window_height, double budget) :
+    window_width{window_width}, window_height{window_height}, width{window_width / WINDOW_FRACTION},
+    height{window_height / WINDOW_FRACTION}, budget{budget}, parameter{DEFAULT_PARAMETER[0], DEFAULT_PARAMETER[1]},
+    texture{::create_iteration_texture(width, height)}, framebuffer{::create_framebuffer()},
+    view_buffer{::create_uniform_buffer(sizeof(TilePyramid::ViewParameters))},
+    started{::create_query(GL_TIMESTAMP)}, finished{::create_query(GL_TIMESTAMP)}
+{
+    if (!(budget > 0.0))
+        throw std::runtime_error{"julia budget must be positive"};
+
+    ::glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT0, texture, 0);
+    if (::glCheckNamedFramebufferStatus(framebuffer, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        throw std::runtime_error{"incomplete framebuffer"};
+}
+
+JuliaPreview::~JuliaPreview()
+{
+    if (fence)
+        ::glDeleteSync(fence);
+}
+
+bool JuliaPreview::covers(int x, int y) const noexcept
+{
+    const int left = window_width - MARGIN - width;
+    return x >= left && x < left + width && y >= MARGIN && y < MARGIN + height;
+}
+
+void JuliaPreview::set_parameter(double x, double y) noexcept
+{
+    parameter[0] = x;
+    parameter[1] = y;
+}
+
+void JuliaPreview::set_iteration_program(GLuint program) noexcept
+{
+    iteration_program = program;
+    ++program_generation;
+}
+
+bool JuliaPreview::collect()
+{
+    if (!fence)
+        return true;
+
+    const GLenum status = ::glClientWaitSync(fence, 0, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        return false;
+
+    GLuint64 start = 0;
+    GLuint64 end = 0;
+    ::glGetQueryObjectui64v(started, GL_QUERY_RESULT, &start);
+    ::glGetQueryObjectui64v(finished, GL_QUERY_RESULT, &end);
+
+    const double cost = (end > start ? end - start : 0) * 1e-6 / (rendered_width * rendered_height);
+    pixel_cost += SMOOTHING * (cost - pixel_cost);
+
+    ::glDeleteSync(fence);
+    fence = nullptr;
+
+    return true;
+}
+
+void JuliaPreview::render(TilePyramid& pyramid, unsigned max_iterations, double scale)
+{
+    const TraceScope trace{"render_julia"};
+
+    // the same area at any scale, only the pixels grow
+    const double pixel_size = EXTENT / std::min(width, height);
+    const double half_w = 0.5 * width  * pixel_size;
+    const double half_h = 0.5 * height * pixel_size;
+    const int render_width  = std::max(1, static_cast<int>(std::lround(width  * scale)));
+    const int render_height = std::max(1, static_cast<int>(std::lround(height * scale)));
+
+    TilePyramid::ViewParameters parameters{};
+    parameters.area_w[0] = static_cast<GLfloat>(-half_w);
+    parameters.area_w[1] = static_cast<GLfloat>(half_w);
+    parameters.area_h[0] = static_cast<GLfloat>(-half_h);
+    parameters.area_h[1] = static_cast<GLfloat>(half_h);
+    parameters.precise_area_w[0] = -half_w;
+    parameters.precise_area_w[1] = half_w;
+    parameters.precise_area_h[0] = -half_h;
+    parameters.precise_area_h[1] = half_h;
+    parameters.target_size[0] = static_cast<GLfloat>(render_width);
+    parameters.target_size[1] = static_cast<GLfloat>(render_height);
+    parameters.max_iterations = max_iterations;
+    parameters.julia_parameter[0] = parameter[0];
+    parameters.julia_parameter[1] = parameter[1];
+    ::glNamedBufferSubData(view_buffer, 0, sizeof(parameters), &parameters);
+
+    ::glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    ::glViewport(0, 0, render_width, render_height);
+    pyramid.use_program(iteration_program);
+
+    ::glQueryCounter(started, GL_TIMESTAMP);
+    ::glDrawArrays(GL_TRIANGLES, 0, 3);
+    ::glQueryCounter(finished, GL_TIMESTAMP);
+    fence = ::glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    ::glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    rendered_generation = program_generation;
+    rendered_parameter[0] = parameter[0];
+    rendered_parameter[1] = parameter[1];
+    rendered_iterations = max_iterations;
+    rendered_width = render_width;
+    rendered_height = render_height;
+}
+
+void JuliaPreview::draw(TilePyramid& pyramid, unsigned max_iterations, const ColorOptions& options)
+{
+    const TraceScope trace{"julia_preview"};
+
+    if (!iteration_program)
+        return;
+
+    // the view block is shared with the pyramid, whose buffer is bound back below
+    ::glBindBufferBase(GL_UNIFORM_BUFFER, TilePyramid::VIEW_BINDING, view_buffer);
+
+    const bool current = program_generation == rendered_generation && max_iterations == rendered_iterations &&
+                         parameter[0] == rendered_parameter[0] && parameter[1] == rendered_parameter[1];
+    if ((!current || rendered_width < width) && collect())
+    {
+        const double fitting = std::sqrt(budget / (std::max(pixel_cost, 1e-9) * width * height));
+        render(pyramid, max_iterations, current ? 1.0 : std::max(MIN_SCALE, std::min(1.0, fitting)));
+        rendered_distance_estimation = options.distance_estimation;
+    }
+
+    if (rendered_generation)
+    {
+        TilePyramid::ViewParameters parameters{};
+        parameters.target_size[0] = static_cast<GLfloat>(width);
+        parameters.target_size[1] = static_cast<GLfloat>(height);
+        parameters.max_iterations = rendered_iterations;
+        parameters.heatmap = options.heatmap;
+        parameters.distance_estimation = rendered_distance_estimation;
+        ::glNamedBufferSubData(view_buffer, 0, sizeof(parameters), &parameters);
+
+        const int left = window_width - MARGIN - width;
+        const int bottom = window_height - MARGIN - height;
+
+        ::glViewport(0, 0, window_width, window_height);
+        pyramid.use_program(pyramid.get_programs().color_program);
+        ::glUniform4f(5, 2.0F * left / window_width - 1.0F, 2.0F * bottom / window_height - 1.0F,
+                         2.0F * (left + width) / window_width - 1.0F, 2.0F * (bottom + height) / window_height - 1.0F);
+        ::glUniform4f(6, 0.0F, 0.0F, static_cast<GLfloat>(rendered_width) / width,
+                         static_cast<GLfloat>(rendered_height) / height);
+        ::glBindTextureUnit(0, texture);
+        ::glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        ::glBindTextureUnit(0, 0);
+    }
+
+    ::glBindBufferBase(GL_UNIFORM_BUFFER, TilePyramid::VIEW_BINDING, pyramid.get_view_buffer());
+}
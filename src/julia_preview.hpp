@@ -0,0 +1,65 @@
+#ifndef JULIA_PREVIEW_HPP
+#define JULIA_PREVIEW_HPP
+
+#include "gl_resources.hpp"
+#include "tile_pyramid.hpp"
+
+// Picture-in-picture Julia set over the top right corner of the main view, for a parameter that
+// follows the pointer. It is iterated by the JULIA permutation of the iteration shader into a
+// texture of its own and drawn by the main color shader. While the parameter moves, each render gets
+// as many pixels as its measured GPU cost per pixel fits into the budget, and the next one starts
+// only once the previous has finished; a parameter that rests is rendered once more at full size.
+class JuliaPreview
+{
+    static constexpr int MARGIN = 8;        // window pixels to the window's edges
+
+    int window_width;
+    int window_height;
+    int width;
+    int height;
+    double budget;                          // GPU milliseconds per render while the parameter moves
+    double pixel_cost = 1e-4;               // milliseconds, smoothed over renders
+    double parameter[2];
+    GLuint iteration_program = 0;
+    // bumped with every program set: a rebuilt program may get the name of the one it replaced
+    unsigned program_generation = 0;
+
+    GLtexture texture;
+    GLframebuffer framebuffer;
+    GLbuffer view_buffer;
+    GLquery started;
+    GLquery finished;
+    GLsync fence = nullptr;
+
+    // what the texture holds; generation 0 while it is empty
+    unsigned rendered_generation = 0;
+    double rendered_parameter[2]{};
+    unsigned rendered_iterations = 0;
+    bool rendered_distance_estimation = false;
+    int rendered_width = 0;
+    int rendered_height = 0;
+
+    // false while the previous render is in flight
+    bool collect();
+    void render(TilePyramid& pyramid, unsigned max_iterations, double scale);
+
+public:
+    JuliaPreview(int window_width, int window_height, double budget);
+    JuliaPreview(const JuliaPreview&) = delete;
+    ~JuliaPreview();
+
+    JuliaPreview& operator=(const JuliaPreview&) = delete;
+
+    // Window pixels, counted from the top left like SDL's.
+    bool covers(int x, int y) const noexcept;
+    void set_parameter(double x, double y) noexcept;
+    // The JULIA permutation of the iteration shader; call again whenever it is rebuilt.
+    void set_iteration_program(GLuint program) noexcept;
+
+    // Renders the parameter as far as the budget allows and draws the latest render with the pyramid's
+    // color program. Statistics and equalization stay with the main view. Programs are switched
+    // through the pyramid, and its view buffer is bound again afterwards.
+    void draw(TilePyramid& pyramid, unsigned max_iterations, const ColorOptions& options);
+};
+
+#endif
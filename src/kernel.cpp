@@ -0,0 +1,529 @@
+#include "kernel.hpp"
+#include "trace.hpp"
+
+#include <stdexcept>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+
+namespace
+{
+    constexpr double SERIES_TOLERANCE = 1e-6;
+    constexpr double SERIES_LIMIT     = 1e150;
+
+    constexpr double FP64_PIXEL_LIMIT = 1e-13;
+
+    // as in mandelbrot_shader.fs; the distance estimate is only accurate far beyond 2
+    constexpr double DISTANCE_ESCAPE_RADIUS = 256.0;
+
+    // two of the 16-byte vector registers every x86-64 and ARMv8 CPU has, 8 floats or 4 doubles:
+    // the second half hides the latency of the first (measured 1.5-1.8x over one pixel at a time)
+    constexpr std::size_t SIMD_BYTES = 32;
+
+    // The formulas are policies of the direct kernel rather than a switch inside it, so that each
+    // gets an inner loop of its own.
+    struct MandelbrotFormula
+    {
+        template <typename T>
+        static void step(T& zx, T& zy, T cx, T cy) noexcept
+        {
+            const T x = zx * zx - zy * zy + cx;
+            zy = 2 * zx * zy + cy;
+            zx = x;
+        }
+    };
+
+    template <unsigned POWER>
+    struct MultibrotFormula
+    {
+        template <typename T>
+        static void step(T& zx, T& zy, T cx, T cy) noexcept
+        {
+            T px = zx, py = zy;
+            for (unsigned i = 1; i < POWER; ++i)
+            {
+                const T x = px * zx - py * zy;
+                py = px * zy + py * zx;
+                px = x;
+            }
+            zx = px + cx;
+            zy = py + cy;
+        }
+    };
+
+    struct BurningShipFormula
+    {
+        template <typename T>
+        static void step(T& zx, T& zy, T cx, T cy) noexcept
+        {
+            const T x = zx * zx - zy * zy + cx;
+            zy = 2 * std::fabs(zx * zy) + cy;
+            zx = x;
+        }
+    };
+
+    struct TricornFormula
+    {
+        template <typename T>
+        static void step(T& zx, T& zy, T cx, T cy) noexcept
+        {
+            const T x = zx * zx - zy * zy + cx;
+            zy = -2 * zx * zy + cy;
+            zx = x;
+        }
+    };
+
+    // Iterates WIDTH neighbouring pixels of a row in lockstep, written so that the compiler can keep
+    // each variable of all lanes in one vector register. Escaped lanes are frozen, not dropped, until
+    // the last one escapes; the counts are those of iterating each pixel on its own.
+    template <typename Formula, typename T, std::size_t WIDTH>
+    void iterate_lanes(const T* cx, T cy, unsigned max_iterations, std::uint32_t* output) noexcept
+    {
+        T zx[WIDTH] = {};
+        T zy[WIDTH] = {};
+        std::uint32_t iterations[WIDTH] = {};
+
+        for (unsigned n = 0; n < max_iterations; ++n)
+        {
+            bool active = false;
+            for (std::size_t lane = 0; lane < WIDTH; ++lane)
+            {
+                T x = zx[lane], y = zy[lane];
+                Formula::step(x, y, cx[lane], cy);
+
+                const bool bounded = x * x + y * y <= 4;
+                zx[lane] = bounded ? x : zx[lane];
+                zy[lane] = bounded ? y : zy[lane];
+                iterations[lane] += bounded;
+                active |= bounded;
+            }
+
+            if (!active)
+                break;
+        }
+
+        std::copy_n(iterations, WIDTH, output);
+    }
+
+    template <typename Formula, typename T>
+    void render_row(const Viewport& viewport, double center_x, double cy, unsigned max_iterations,
+                    std::uint32_t* output) noexcept
+    {
+        constexpr std::size_t WIDTH = SIMD_BYTES / sizeof(T);
+
+        const auto pixel_x = [&](int column)
+        {
+            return static_cast<T>(center_x + (column - 0.5 * (viewport.width - 1)) * viewport.pixel_size);
+        };
+
+        T cx[WIDTH];
+        int column = 0;
+        for (; column + static_cast<int>(WIDTH) <= viewport.width; column += WIDTH)
+        {
+            for (std::size_t lane = 0; lane < WIDTH; ++lane)
+                cx[lane] = pixel_x(column + static_cast<int>(lane));
+            ::iterate_lanes<Formula, T, WIDTH>(cx, static_cast<T>(cy), max_iterations, output + column);
+        }
+        for (; column < viewport.width; ++column)
+        {
+            cx[0] = pixel_x(column);
+            ::iterate_lanes<Formula, T, 1>(cx, static_cast<T>(cy), max_iterations, output + column);
+        }
+    }
+
+    using row_renderer = void (*)(const Viewport&, double, double, unsigned, std::uint32_t*);
+
+    template <typename T>
+    row_renderer direct_renderer(Formula formula)
+    {
+        switch (formula)
+        {
+            case Formula::mandelbrot:   return &::render_row<MandelbrotFormula, T>;
+            case Formula::multibrot3:   return &::render_row<MultibrotFormula<3>, T>;
+            case Formula::multibrot4:   return &::render_row<MultibrotFormula<4>, T>;
+            case Formula::burning_ship: return &::render_row<BurningShipFormula, T>;
+            case Formula::tricorn:      return &::render_row<TricornFormula, T>;
+        }
+        throw std::runtime_error{"unknown formula"};
+    }
+
+    // Sets distance to the exterior distance estimate in the units of C, 0 if C did not escape.
+    template <typename T>
+    std::uint32_t iterate_distance(T cx, T cy, unsigned max_iterations, double& distance) noexcept
+    {
+        T zx = 0, zy = 0;
+        T dx = 0, dy = 0;   // dZ/dC
+        unsigned iteration = 0;
+        distance = 0.0;
+
+        while (iteration < max_iterations)
+        {
+            const T ndx = 2 * (zx * dx - zy * dy) + 1;
+            const T ndy = 2 * (zx * dy + zy * dx);
+            dx = ndx;
+            dy = ndy;
+
+            const T x = zx * zx - zy * zy + cx;
+            const T y = 2 * zx * zy       + cy;
+
+            const double magnitude = static_cast<double>(x) * x + static_cast<double>(y) * y;
+            if (magnitude > DISTANCE_ESCAPE_RADIUS * DISTANCE_ESCAPE_RADIUS)
+            {
+                distance = std::sqrt(magnitude / (static_cast<double>(dx) * dx + static_cast<double>(dy) * dy)) *
+                           0.5 * std::log(magnitude);
+                break;
+            }
+
+            zx = x;
+            zy = y;
+
+            ++iteration;
+        }
+
+        return iteration;
+    }
+
+    // Perturbation iteration around the reference orbit. When the pixel orbit gets closer to the
+    // origin than to the reference, or the reference runs out, the delta is rebased onto the start
+    // of the reference; this removes glitches without needing secondary references.
+    std::uint32_t iterate_perturbed(const std::vector<std::complex<double>>& orbit, double dcx, double dcy,
+                                    double dx, double dy, unsigned n, unsigned iteration, unsigned max_iterations) noexcept
+    {
+        const std::size_t last = orbit.size() - 1;
+
+        while (iteration < max_iterations)
+        {
+            const double rx = orbit[n].real();
+            const double ry = orbit[n].imag();
+
+            const double nx = 2 * (rx * dx - ry * dy) + dx * dx - dy * dy + dcx;
+            const double ny = 2 * (rx * dy + ry * dx) + 2 * dx * dy       + dcy;
+
+            const double zx = orbit[n + 1].real() + nx;
+            const double zy = orbit[n + 1].imag() + ny;
+            const double norm_z = zx * zx + zy * zy;
+
+            if (norm_z > 4.0)
+                break;
+
+            dx = nx;
+            dy = ny;
+            ++n;
+            ++iteration;
+
+            if (n == last || norm_z < dx * dx + dy * dy)
+            {
+                dx = zx;
+                dy = zy;
+                n = 0;
+            }
+        }
+
+        return iteration;
+    }
+
+    // Lowers the series skip until the approximation agrees with real perturbation iteration at the
+    // viewport's corners and edge midpoints.
+    unsigned validated_skip(const ReferenceOrbit& reference_orbit, const Viewport& viewport,
+                            double offset_x, double offset_y, unsigned skip) noexcept
+    {
+        const auto& orbit = reference_orbit.get_orbit();
+        const double half_w = 0.5 * viewport.width  * viewport.pixel_size;
+        const double half_h = 0.5 * viewport.height * viewport.pixel_size;
+
+        for (int px = -1; px <= 1; ++px)
+        {
+            for (int py = -1; py <= 1; ++py)
+            {
+                if (px == 0 && py == 0)
+                    continue;
+
+                const std::complex<double> dc{offset_x + px * half_w, offset_y + py * half_h};
+                std::complex<double> delta{};
+
+                for (unsigned n = 0; n < skip; ++n)
+                {
+                    delta = (2.0 * orbit[n] + delta) * delta + dc;
+                    const std::complex<double> z = orbit[n + 1] + delta;
+                    const std::complex<double> error = reference_orbit.series_delta(n + 1, dc) - delta;
+
+                    if (std::norm(z) > 4.0 || std::norm(z) < std::norm(delta) ||
+                        std::abs(error) > SERIES_TOLERANCE * std::abs(delta))
+                    {
+                        skip = n;
+                        break;
+                    }
+                }
+            }
+        }
+
+        return skip;
+    }
+}
+
+const char* precision_name(Precision precision) noexcept
+{
+    switch (precision)
+    {
+        case Precision::fp32:         return "fp32";
+        case Precision::fp64:         return "fp64";
+        case Precision::perturbation: return "perturbation";
+    }
+    return "unknown";
+}
+
+Precision parse_precision(const std::string& name)
+{
+    if (name == "fp32")         return Precision::fp32;
+    if (name == "fp64")         return Precision::fp64;
+    if (name == "perturbation") return Precision::perturbation;
+
+    throw std::runtime_error{"unknown precision: " + name};
+}
+
+Precision default_precision(double pixel_size) noexcept
+{
+    return pixel_size > FP64_PIXEL_LIMIT ? Precision::fp64 : Precision::perturbation;
+}
+
+const char* formula_name(Formula formula) noexcept
+{
+    switch (formula)
+    {
+        case Formula::mandelbrot:   return "mandelbrot";
+        case Formula::multibrot3:   return "multibrot3";
+        case Formula::multibrot4:   return "multibrot4";
+        case Formula::burning_ship: return "burning-ship";
+        case Formula::tricorn:      return "tricorn";
+    }
+    return "unknown";
+}
+
+Formula parse_formula(const std::string& name)
+{
+    if (name == "mandelbrot")   return Formula::mandelbrot;
+    if (name == "multibrot3")   return Formula::multibrot3;
+    if (name == "multibrot4")   return Formula::multibrot4;
+    if (name == "burning-ship") return Formula::burning_ship;
+    if (name == "tricorn")      return Formula::tricorn;
+
+    throw std::runtime_error{"unknown formula: " + name};
+}
+
+bool is_holomorphic(Formula formula) noexcept
+{
+    return formula != Formula::burning_ship && formula != Formula::tricorn;
+}
+
+void parallel_for(int count, unsigned thread_limit, const std::function<void(int)>& body)
+{
+    const unsigned limit = thread_limit ? thread_limit : std::thread::hardware_concurrency();
+    const int thread_count = std::max(1, std::min(count, static_cast<int>(limit)));
+
+    std::atomic<int> next{0};
+    const auto work = [&]
+    {
+        const TraceScope trace{"render_rows"};
+        for (int index = next++; index < count; index = next++)
+            body(index);
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < thread_count; ++i)
+        threads.emplace_back(work);
+    work();
+    for (auto& thread : threads)
+        thread.join();
+}
+
+Viewport make_viewport(const View& view, int width, int height) noexcept
+{
+    return {view.center_x, view.center_y, 2.0 * view.scale / height, width, height};
+}
+
+ReferenceOrbit::ReferenceOrbit(const HighPrecision& center_x, const HighPrecision& center_y, unsigned max_iterations) :
+    center_x{center_x}, center_y{center_y}, max_iterations{max_iterations}
+{
+    const TraceScope trace{"reference_orbit"};
+
+    HighPrecision zx, zy;
+    std::complex<double> a{}, b{}, c{};
+    bool series_growing = true;
+
+    for (unsigned n = 0;; ++n)
+    {
+        const std::complex<double> z{zx.to_double(), zy.to_double()};
+        orbit.push_back(z);
+
+        if (series_growing)
+        {
+            series_a.push_back(a);
+            series_b.push_back(b);
+            series_c.push_back(c);
+
+            const std::complex<double> next_a = 2.0 * z * a + 1.0;
+            const std::complex<double> next_b = 2.0 * z * b + a * a;
+            const std::complex<double> next_c = 2.0 * z * c + 2.0 * a * b;
+            a = next_a;
+            b = next_b;
+            c = next_c;
+
+            series_growing = std::abs(a) < SERIES_LIMIT && std::abs(b) < SERIES_LIMIT && std::abs(c) < SERIES_LIMIT;
+        }
+
+        if (n == max_iterations || std::norm(z) > 4.0)
+            break;
+
+        const HighPrecision x = zx * zx - zy * zy + center_x;
+        const HighPrecision y = (zx + zx) * zy    + center_y;
+        zx = x;
+        zy = y;
+    }
+}
+
+unsigned ReferenceOrbit::series_skip(double radius) const noexcept
+{
+    const std::size_t length = std::min(series_a.size(), orbit.size() - 1);
+
+    unsigned skip = 0;
+    for (std::size_t n = 1; n < length; ++n)
+    {
+        if (std::abs(series_c[n]) * radius * radius > SERIES_TOLERANCE * std::abs(series_a[n]))
+            break;
+        skip = static_cast<unsigned>(n);
+    }
+    return skip;
+}
+
+std::complex<double> ReferenceOrbit::series_delta(unsigned n, std::complex<double> dc) const noexcept
+{
+    return ((series_c[n] * dc + series_b[n]) * dc + series_a[n]) * dc;
+}
+
+IterationBuffer render_iterations(const Viewport& viewport, unsigned max_iterations, Precision precision,
+                                  unsigned thread_count, Formula formula)
+{
+    if (precision == Precision::perturbation)
+    {
+        if (formula != Formula::mandelbrot)
+            throw std::runtime_error{std::string{"no perturbation kernel for "} + ::formula_name(formula)};
+
+        return ::render_iterations(viewport, ReferenceOrbit{viewport.center_x, viewport.center_y, max_iterations},
+                                   thread_count);
+    }
+
+    IterationBuffer buffer{viewport.width, viewport.height,
+                           std::vector<std::uint32_t>(static_cast<std::size_t>(viewport.width) * viewport.height)};
+
+    const double center_x = viewport.center_x.to_double();
+    const double center_y = viewport.center_y.to_double();
+
+    const row_renderer render_row = precision == Precision::fp32 ? ::direct_renderer<float>(formula) :
+                                                                   ::direct_renderer<double>(formula);
+
+    ::parallel_for(viewport.height, thread_count, [&](int row)
+    {
+        const double cy = center_y + (0.5 * (viewport.height - 1) - row) * viewport.pixel_size;
+        render_row(viewport, center_x, cy, max_iterations, &buffer.iterations[static_cast<std::size_t>(row) * viewport.width]);
+    });
+
+    return buffer;
+}
+
+DistanceEstimate render_distance_estimate(const Viewport& viewport, unsigned max_iterations, Precision precision,
+                                          unsigned thread_count)
+{
+    if (precision == Precision::perturbation)
+        throw std::runtime_error{"distance estimation needs fp32 or fp64"};
+
+    const std::size_t pixel_count = static_cast<std::size_t>(viewport.width) * viewport.height;
+    DistanceEstimate estimate{{viewport.width, viewport.height, std::vector<std::uint32_t>(pixel_count)},
+                              std::vector<float>(pixel_count)};
+
+    const double center_x = viewport.center_x.to_double();
+    const double center_y = viewport.center_y.to_double();
+
+    // in pixels, clamped to the limit
+    const auto sample = [&](double cx, double cy, std::uint32_t& iteration)
+    {
+        double distance;
+        iteration = precision == Precision::fp32 ?
+            ::iterate_distance<float>(static_cast<float>(cx), static_cast<float>(cy), max_iterations, distance) :
+            ::iterate_distance<double>(cx, cy, max_iterations, distance);
+
+        return std::min(distance / viewport.pixel_size, static_cast<double>(DistanceEstimate::DISTANCE_LIMIT));
+    };
+
+    std::atomic<std::size_t> supersampled{0};
+
+    ::parallel_for(viewport.height, thread_count, [&](int row)
+    {
+        const double cy = center_y + (0.5 * (viewport.height - 1) - row) * viewport.pixel_size;
+        const std::size_t offset = static_cast<std::size_t>(row) * viewport.width;
+        std::size_t row_supersampled = 0;
+
+        for (int column = 0; column < viewport.width; ++column)
+        {
+            const double cx = center_x + (column - 0.5 * (viewport.width - 1)) * viewport.pixel_size;
+
+            std::uint32_t& iteration = estimate.buffer.iterations[offset + column];
+            double pixels = sample(cx, cy, iteration);
+
+            // far from the boundary one sample is enough, and so it is inside the set, where
+            // every further sample would run all max_iterations again
+            if (pixels > 0.0 && pixels < 1.0)
+            {
+                ++row_supersampled;
+                std::uint32_t sample_iteration;
+                for (int i = 0; i < 4; ++i)
+                    pixels += sample(cx + ((i & 1) - 0.5) * 0.5 * viewport.pixel_size,
+                                     cy + ((i >> 1) - 0.5) * 0.5 * viewport.pixel_size, sample_iteration);
+                pixels /= 5.0;
+            }
+
+            estimate.distances[offset + column] = static_cast<float>(pixels);
+        }
+
+        supersampled += row_supersampled;
+    });
+
+    estimate.supersampled = supersampled;
+    return estimate;
+}
+
+IterationBuffer render_iterations(const Viewport& viewport, const ReferenceOrbit& reference_orbit, unsigned thread_count)
+{
+    IterationBuffer buffer{viewport.width, viewport.height,
+                           std::vector<std::uint32_t>(static_cast<std::size_t>(viewport.width) * viewport.height)};
+
+    const auto& orbit = reference_orbit.get_orbit();
+    const unsigned max_iterations = reference_orbit.get_max_iterations();
+
+    const double offset_x = (viewport.center_x - reference_orbit.get_center_x()).to_double();
+    const double offset_y = (viewport.center_y - reference_orbit.get_center_y()).to_double();
+
+    const double radius = std::hypot(std::fabs(offset_x) + 0.5 * viewport.width  * viewport.pixel_size,
+                                     std::fabs(offset_y) + 0.5 * viewport.height * viewport.pixel_size);
+    const unsigned skip = ::validated_skip(reference_orbit, viewport, offset_x, offset_y,
+                                           reference_orbit.series_skip(radius));
+
+    ::parallel_for(viewport.height, thread_count, [&](int row)
+    {
+        const double dcy = offset_y + (0.5 * (viewport.height - 1) - row) * viewport.pixel_size;
+        std::uint32_t* const output = &buffer.iterations[static_cast<std::size_t>(row) * viewport.width];
+
+        for (int column = 0; column < viewport.width; ++column)
+        {
+            const double dcx = offset_x + (column - 0.5 * (viewport.width - 1)) * viewport.pixel_size;
+            const std::complex<double> delta = skip ? reference_orbit.series_delta(skip, {dcx, dcy}) : 0.0;
+
+            output[column] = ::iterate_perturbed(orbit, dcx, dcy, delta.real(), delta.imag(),
+                                                 skip, std::min(skip, max_iterations), max_iterations);
+        }
+    });
+
+    buffer.series_skip = std::min(skip, max_iterations);
+    return buffer;
+}
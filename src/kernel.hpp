@@ -0,0 +1,125 @@
+#ifndef KERNEL_HPP
+#define KERNEL_HPP
+
+#include "fixed_point.hpp"
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <complex>
+#include <functional>
+
+enum class Precision
+{
+    fp32,
+    fp64,
+    perturbation
+};
+
+const char* precision_name(Precision precision) noexcept;
+Precision parse_precision(const std::string& name);
+// fp64 is exact enough until the pixel size approaches the double epsilon around the set.
+Precision default_precision(double pixel_size) noexcept;
+
+// The iterated map. Perturbation, distance estimation and the viewer's interior detection exist
+// for the holomorphic ones only.
+enum class Formula
+{
+    mandelbrot,     // z^2 + c
+    multibrot3,     // z^3 + c
+    multibrot4,     // z^4 + c
+    burning_ship,   // (|Re z| + i |Im z|)^2 + c
+    tricorn         // conj(z)^2 + c
+};
+
+const char* formula_name(Formula formula) noexcept;
+Formula parse_formula(const std::string& name);
+bool is_holomorphic(Formula formula) noexcept;
+
+// A pixel grid over the complex plane. Row 0 is the top of the image.
+struct Viewport
+{
+    HighPrecision center_x;
+    HighPrecision center_y;
+    double pixel_size;
+    int width;
+    int height;
+};
+
+// Centre and half-height of a region of the complex plane, independent of the output size.
+struct View
+{
+    HighPrecision center_x;
+    HighPrecision center_y;
+    double scale;
+};
+
+struct IterationBuffer
+{
+    int width;
+    int height;
+    std::vector<std::uint32_t> iterations;
+    // leading iterations of every count that series approximation skipped instead of running; not
+    // kept by the disk cache
+    unsigned series_skip = 0;
+};
+
+// Iteration counts together with each pixel's exterior distance to the boundary of the set, in
+// pixels: 0 where the orbit stays bounded, at most DISTANCE_LIMIT.
+struct DistanceEstimate
+{
+    static constexpr float DISTANCE_LIMIT = 4.0F;
+
+    IterationBuffer buffer;
+    std::vector<float> distances;
+    // pixels that took the four extra samples
+    std::size_t supersampled = 0;
+};
+
+// High-precision orbit of a single reference point plus the series approximation
+// dz_n ~ A_n dc + B_n dc^2 + C_n dc^3 of nearby orbits. Building it is the expensive part
+// of a perturbation render, so one instance can be shared by every viewport around its centre.
+class ReferenceOrbit
+{
+    HighPrecision center_x;
+    HighPrecision center_y;
+    unsigned max_iterations;
+
+    std::vector<std::complex<double>> orbit;
+    std::vector<std::complex<double>> series_a;
+    std::vector<std::complex<double>> series_b;
+    std::vector<std::complex<double>> series_c;
+
+public:
+    ReferenceOrbit(const HighPrecision& center_x, const HighPrecision& center_y, unsigned max_iterations);
+
+    const HighPrecision& get_center_x() const noexcept {return center_x;}
+    const HighPrecision& get_center_y() const noexcept {return center_y;}
+    unsigned get_max_iterations() const noexcept {return max_iterations;}
+
+    const std::vector<std::complex<double>>& get_orbit() const noexcept {return orbit;}
+
+    // Number of iterations the series may skip for every |dc| <= radius, before probe validation.
+    unsigned series_skip(double radius) const noexcept;
+    std::complex<double> series_delta(unsigned n, std::complex<double> dc) const noexcept;
+};
+
+Viewport make_viewport(const View& view, int width, int height) noexcept;
+
+// Calls body for every index below count, handed out one at a time to up to thread_limit threads
+// (0 for every hardware thread), the calling thread included.
+void parallel_for(int count, unsigned thread_limit, const std::function<void(int)>& body);
+
+// thread_count 0 spreads the rows over every hardware thread. Perturbation is for the Mandelbrot
+// formula only.
+IterationBuffer render_iterations(const Viewport& viewport, unsigned max_iterations, Precision precision,
+                                  unsigned thread_count = 0, Formula formula = Formula::mandelbrot);
+IterationBuffer render_iterations(const Viewport& viewport, const ReferenceOrbit& reference_orbit,
+                                  unsigned thread_count = 0);
+// Carries dZ/dC along each orbit for the estimate |Z| log |Z| / |dZ/dC|. Escaped pixels within one
+// pixel of the boundary average in four more samples a quarter pixel off, as the viewer's shader does.
+// fp32 and fp64 only; the counts escape at radius 256 rather than 2.
+DistanceEstimate render_distance_estimate(const Viewport& viewport, unsigned max_iterations, Precision precision,
+                                          unsigned thread_count = 0);
+
+#endif
@@ -0,0 +1,110 @@
+#include "load_test.hpp"
+#include "socket.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+    // Returns the HTTP status code; the body is read to the end of the connection and discarded.
+    int fetch(const std::string& host, unsigned short port, const std::string& path, std::size_t& bytes)
+    {
+        const Socket connection{::connect_socket(host, port)};
+
+        const std::string request = "GET " + path + " HTTP/1.1\r\nHost: " + host + "\r\nConnection: close\r\n\r\n";
+        ::send_all(connection, request.data(), request.size());
+
+        std::string head;
+        char buffer[16384];
+        for (std::size_t received; (received = ::receive_some(connection, buffer, sizeof(buffer)));)
+        {
+            if (head.size() < 16)
+                head.append(buffer, std::min<std::size_t>(received, 16));
+            bytes += received;
+        }
+
+        if (head.compare(0, 5, "HTTP/") != 0 || head.size() < 12)
+            throw std::runtime_error{"malformed response"};
+
+        return std::stoi(head.substr(9, 3));
+    }
+
+    std::string tile_path(unsigned zoom, unsigned index)
+    {
+        // walk the tiles of the level from the centre outwards so that most of them show detail
+        const unsigned long long side = 1ULL << zoom;
+        const unsigned long long span = std::min<unsigned long long>(side, 16);
+        const unsigned long long base = (side - span) / 2;
+
+        return '/' + std::to_string(zoom) + '/' + std::to_string(base + index % span) + '/' +
+               std::to_string(base + index / span % span) + ".png";
+    }
+}
+
+void run_load_test(const LoadTestSettings& settings)
+{
+    if (settings.request_count == 0 || settings.concurrency == 0 || settings.distinct_tiles == 0)
+        throw std::runtime_error{"load test needs at least one request, client and tile"};
+    if (settings.zoom > 63)
+        throw std::runtime_error{"zoom level must not exceed 63"};
+
+    std::atomic<unsigned> next{0};
+    std::atomic<unsigned> failures{0};
+    std::atomic<std::size_t> total_bytes{0};
+    std::mutex latencies_mutex;
+    std::vector<double> latencies;
+
+    const auto started = std::chrono::steady_clock::now();
+
+    const auto client = [&]
+    {
+        std::vector<double> local_latencies;
+        std::size_t bytes = 0;
+
+        for (unsigned index = next++; index < settings.request_count; index = next++)
+        {
+            const auto request_started = std::chrono::steady_clock::now();
+            try
+            {
+                if (::fetch(settings.host, settings.port, ::tile_path(settings.zoom, index % settings.distinct_tiles), bytes) != 200)
+                    ++failures;
+            }
+            catch (const std::exception&)
+            {
+                ++failures;
+            }
+            local_latencies.push_back(std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - request_started).count());
+        }
+
+        total_bytes += bytes;
+        const std::lock_guard<std::mutex> lock{latencies_mutex};
+        latencies.insert(latencies.end(), local_latencies.begin(), local_latencies.end());
+    };
+
+    std::vector<std::thread> clients;
+    for (unsigned i = 0; i < settings.concurrency; ++i)
+        clients.emplace_back(client);
+    for (auto& thread : clients)
+        thread.join();
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    std::sort(latencies.begin(), latencies.end());
+    const auto percentile = [&latencies](double p) {return latencies[static_cast<std::size_t>(p * (latencies.size() - 1))];};
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "requests:   " << latencies.size() << " (" << failures << " failed)\n"
+              << "wall time:  " << seconds << " s\n"
+              << "throughput: " << latencies.size() / seconds << " req/s, "
+                                << total_bytes / seconds / 1048576.0 << " MiB/s\n"
+              << "latency ms: p50 " << percentile(0.5) << ", p90 " << percentile(0.9)
+              << ", p99 " << percentile(0.99) << ", max " << latencies.back() << std::endl;
+}
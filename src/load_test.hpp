@@ -0,0 +1,19 @@
+#ifndef LOAD_TEST_HPP
+#define LOAD_TEST_HPP
+
+#include <string>
+
+struct LoadTestSettings
+{
+    std::string host;
+    unsigned short port;
+    unsigned request_count;
+    unsigned concurrency;
+    unsigned zoom;
+    unsigned distinct_tiles;    // requests cycle through this many tiles, so repeats exercise the caches
+};
+
+// Minimal HTTP benchmark client for the tile server. Prints throughput and latency percentiles.
+void run_load_test(const LoadTestSettings& settings);
+
+#endif
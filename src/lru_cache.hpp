@@ -0,0 +1,65 @@
+#ifndef LRU_CACHE_HPP
+#define LRU_CACHE_HPP
+
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+// Fixed-capacity map that evicts the least recently used entry. Not synchronized.
+template <typename Key, typename Value>
+class LruCache
+{
+    using entry_list = std::list<std::pair<Key, Value>>;
+
+    std::size_t capacity;
+    entry_list entries;
+    std::unordered_map<Key, typename entry_list::iterator> index;
+
+public:
+    explicit LruCache(std::size_t capacity) : capacity{capacity} {}
+
+    bool get(const Key& key, Value& value)
+    {
+        const auto found = index.find(key);
+        if (found == index.end())
+            return false;
+
+        entries.splice(entries.begin(), entries, found->second);
+        value = found->second->second;
+
+        return true;
+    }
+
+    void put(const Key& key, Value value)
+    {
+        if (capacity == 0)
+            return;
+
+        const auto found = index.find(key);
+        if (found != index.end())
+        {
+            found->second->second = std::move(value);
+            entries.splice(entries.begin(), entries, found->second);
+            return;
+        }
+
+        if (entries.size() == capacity)
+        {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+
+        entries.emplace_front(key, std::move(value));
+        index.emplace(key, entries.begin());
+    }
+
+    void clear()
+    {
+        index.clear();
+        entries.clear();
+    }
+
+    std::size_t size() const noexcept {return entries.size();}
+};
+
+#endif
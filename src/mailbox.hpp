@@ -0,0 +1,40 @@
+#ifndef MAILBOX_HPP
+#define MAILBOX_HPP
+
+#include <array>
+#include <atomic>
+
+// Lock-free single-slot channel from one producer thread to one consumer thread: the consumer only
+// ever sees the latest value published, older ones are overwritten. Three buffers rotate through a
+// single atomic index, so neither side waits for the other. T is copied, keep it small.
+template <typename T>
+class Mailbox
+{
+    static constexpr unsigned FRESH = 4;    // set in shared while it holds an unread value
+
+    std::array<T, 3> buffers{};
+    std::atomic<unsigned> shared{1};
+    unsigned back  = 0;     // written by the producer only
+    unsigned front = 2;     // read by the consumer only
+
+public:
+    void publish(const T& value) noexcept
+    {
+        buffers[back] = value;
+        back = shared.exchange(back | FRESH, std::memory_order_acq_rel) & ~FRESH;
+    }
+
+    // Returns false, leaving value untouched, if nothing was published since the last call.
+    bool take(T& value) noexcept
+    {
+        if (!(shared.load(std::memory_order_relaxed) & FRESH))
+            return false;
+
+        front = shared.exchange(front, std::memory_order_acq_rel) & ~FRESH;
+        value = buffers[front];
+
+        return true;
+    }
+};
+
+#endif
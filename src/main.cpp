@@ -1,3 +1,32 @@
+#include "arguments.hpp"
+#include "animation.hpp"
+#include "tile_server.hpp"
+#include "load_test.hpp"
+#include "distributed.hpp"
+#include "benchmark.hpp"
+#include "gpu_benchmark.hpp"
+#include "disk_cache.hpp"
+#include "program_cache.hpp"
+#include "shaders.hpp"
+#include "shader_reloader.hpp"
+#include "gl_resources.hpp"
+#include "tile_pyramid.hpp"
+#include "gpu_timer.hpp"
+#include "compute_scheduler.hpp"
+#include "frame_graph.hpp"
+#include "iteration_statistics.hpp"
+#include "histogram_equalizer.hpp"
+#include "julia_preview.hpp"
+#include "trace.hpp"
+#include "mandelbrot_data.hpp"
+#include "input_recording.hpp"
+#include "frame_pacer.hpp"
+#include "readback_ring.hpp"
+#include "image.hpp"
+#include "palette.hpp"
+#include "mailbox.hpp"
+#include "thread_pool.hpp"
+
 #include <GL/glew.h>
 
 #include <SDL2/SDL.h>
@@ -9,313 +38,1050 @@
 #include <utility>
 #include <fstream>
 #include <iterator>
+#include <memory>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
 
 namespace
 {
     constexpr int WINDOW_WIDTH  = 800;
     constexpr int WINDOW_HEIGHT = 600;
 
-    class GLobject
+    constexpr double DEFAULT_COMPUTE_BUDGET = 6.0;     // GPU milliseconds of new tiles per frame
+    constexpr double DEFAULT_JULIA_BUDGET = 1.0;       // GPU milliseconds per Julia preview render
+    constexpr std::size_t GPU_TILE_CAPACITY = 512;
+
+    constexpr double TITLE_INTERVAL = 0.5;
+    constexpr double DEFAULT_FRAME_PERIOD = 1.0 / 60.0;
+    constexpr GLuint PALETTE_UNIT = 1;     // binding of palette in color_shader.fs
+    constexpr int EVENT_TIMEOUT = 10;   // ms, how long the event thread sleeps without events
+
+    const std::chrono::steady_clock::time_point LAUNCHED = std::chrono::steady_clock::now();
+
+    enum RenderPass : std::size_t
+    {
+        TILE_PASS,
+        COLOR_PASS,
+        JULIA_PASS,
+        PASS_COUNT
+    };
+
+    enum ProgramIndex : std::size_t
     {
-    public:
-        using deleter_type = std::function<void(GLuint)>;
+        ITERATION_PROGRAM,
+        DOWNSAMPLE_PROGRAM,
+        COLOR_PROGRAM,
+        JULIA_PROGRAM,
+        PROGRAM_COUNT
+    };
 
-    private:
-        GLuint index;
-        deleter_type deleter;
+    const ShaderFiles PROGRAM_FILES[PROGRAM_COUNT]
+    {
+        {"mandelbrot_shader.vs", "mandelbrot_shader.fs", {}},
+        {"tile_shader.vs", "downsample_shader.fs", {}},
+        {"tile_shader.vs", "color_shader.fs", {}},
+        {"mandelbrot_shader.vs", "mandelbrot_shader.fs", {"JULIA"}}
+    };
 
-    public:
-        GLobject(GLuint index, deleter_type deleter) : index{index}, deleter{std::move(deleter)} {}
-        GLobject(const GLobject&) = delete;
-        GLobject(GLobject&& globject) noexcept : index{globject.index}, deleter{std::move(globject.deleter)}
+    // Compile-time permutations of the iteration shader; each computes its own tiles.
+    struct IterationVariant
+    {
+        Formula formula;
+        bool fp64;
+        bool distance_estimation;   // both need the derivative, ignored for non-holomorphic formulas
+        bool interior_detection;
+    };
+
+    bool uses_distance_estimation(const IterationVariant& variant) noexcept
+    {
+        return variant.distance_estimation && ::is_holomorphic(variant.formula);
+    }
+
+    ShaderFiles iteration_files(const IterationVariant& variant)
+    {
+        ShaderFiles files{PROGRAM_FILES[ITERATION_PROGRAM]};
+        if (variant.fp64)
+            files.defines.push_back("DOUBLE_PRECISION");
+        if (::uses_distance_estimation(variant))
+            files.defines.push_back("DISTANCE_ESTIMATION");
+        if (variant.interior_detection && ::is_holomorphic(variant.formula))
+            files.defines.push_back("INTERIOR_DETECTION");
+
+        switch (variant.formula)
         {
-            globject.index = 0;
+            case Formula::mandelbrot:   break;
+            case Formula::multibrot3:   files.defines.push_back("MULTIBROT_POWER 3"); break;
+            case Formula::multibrot4:   files.defines.push_back("MULTIBROT_POWER 4"); break;
+            case Formula::burning_ship: files.defines.push_back("BURNING_SHIP"); break;
+            case Formula::tricorn:      files.defines.push_back("TRICORN"); break;
         }
-        ~GLobject() {deleter(index);}
 
-        GLobject& operator=(const GLobject&) = delete;
+        return files;
+    }
 
-        GLobject& operator=(GLobject&& globject) noexcept
-        {
-            if (this == &globject) return *this;
+    Precision iteration_precision(const ShaderFiles& files)
+    {
+        return std::find(files.defines.begin(), files.defines.end(), "DOUBLE_PRECISION") != files.defines.end() ?
+            Precision::fp64 : Precision::fp32;
+    }
 
-            index = globject.index;
-            deleter = std::move(globject.deleter);
+    // The preview iterates the same permutation from the pixel, see JuliaPreview.
+    ShaderFiles julia_files(const IterationVariant& variant)
+    {
+        ShaderFiles files{::iteration_files(variant)};
+        files.defines.push_back("JULIA");
 
-            return *this;
-        }
+        return files;
+    }
 
-        operator GLuint() const noexcept {return index;}
+    Formula next_formula(Formula formula) noexcept
+    {
+        return formula == Formula::tricorn ? Formula::mandelbrot : static_cast<Formula>(static_cast<int>(formula) + 1);
+    }
+
+    struct DisplayOptions
+    {
+        bool overlay;
+        bool heatmap;
+        bool equalize;          // histogram-equalized colors
+        IterationVariant variant;
+        bool julia;             // Julia preview of the parameter under the pointer
+        int pointer_x;          // window pixels from the top left, -1 before the pointer first moved
+        int pointer_y;
+        unsigned screenshots;   // F12 presses so far
     };
 
-    struct MandelbrotData
+    // Everything the render thread needs from the event thread for a frame.
+    struct ViewerState
     {
-        float scale;
-        float x;
-        float y;
-        unsigned max_iterations;
+        MandelbrotData mandelbrot_data;
+        DisplayOptions display_options;
     };
 
-    struct RenderData
+    // Shared between the event thread, which owns the window, and the render thread, which owns
+    // the GL context. The state and the input time are lock-free; the title changes rarely.
+    struct ViewerChannel
     {
-        GLuint shader_program;
-        GLuint vertex_array_object;
+        Mailbox<ViewerState> state;
+        std::atomic<Uint32> first_input{0};     // earliest key press no frame has picked up yet
+        std::atomic<bool> running{true};
+        std::exception_ptr error;               // set by the render thread before it stops
+
+        std::mutex title_mutex;
+        std::string title;
+        bool title_changed = false;
     };
 
-    GLobject create_rectangle_buffer()
+    // CPU time covers taking the state and command submission; the interval also includes the swap and
+    // the wait. Input latency runs from the first key event picked up by a frame until its swap returned.
+    struct FrameTimes
     {
-        GLobject buffer
+        RollingAverage cpu_time;
+        RollingAverage interval;
+        RollingAverage input_latency;
+    };
+
+    // Returns the SDL timestamp of the first key press, or pointer motion under the Julia preview,
+    // handled, 0 if there was none.
+    Uint32 do_events(MandelbrotData& mandelbrotData, DisplayOptions& display_options, const std::string& trace_file,
+                     bool& running) noexcept
+    {
+        const TraceScope trace{"do_events"};
+
+        static SDL_Event event;
+        Uint32 first_input = 0;
+
+        while (::SDL_PollEvent(&event))
         {
-            []
+            switch (event.type)
             {
-                GLuint buffer;
-                ::glGenBuffers(1, &buffer);
+                case SDL_KEYDOWN:
+                {
+                    const SDL_Scancode scancode = event.key.keysym.scancode;
+                    if (!first_input)
+                        first_input = std::max<Uint32>(event.key.timestamp, 1);
 
-                if (!buffer)
-                    throw std::runtime_error{"buffer generation error"};
+                    const double scale_per = 0.1 * mandelbrotData.scale;
 
-                return buffer;
+                    if      (scancode == SDL_SCANCODE_W)
+                        mandelbrotData.y += scale_per;
+                    else if (scancode == SDL_SCANCODE_S)
+                        mandelbrotData.y -= scale_per;
 
-            }(), [](GLuint buffer){::glDeleteBuffers(1, &buffer);}
-        };
+                    if      (scancode == SDL_SCANCODE_A)
+                        mandelbrotData.x -= scale_per;
+                    else if (scancode == SDL_SCANCODE_D)
+                        mandelbrotData.x += scale_per;
 
-        constexpr GLfloat rectangle_data[]
-        {
-            -1.0F, -1.0F, 0.0F,
-             1.0F, -1.0F, 0.0F,
-             1.0F,  1.0F, 0.0F,
-             1.0F,  1.0F, 0.0F,
-            -1.0F,  1.0F, 0.0F,
-            -1.0F, -1.0F, 0.0F
-        };
+                    if      (scancode == SDL_SCANCODE_Z)
+                        mandelbrotData.scale -= scale_per;
+                    else if (scancode == SDL_SCANCODE_X)
+                        mandelbrotData.scale += scale_per;
+
+                    if      (scancode == SDL_SCANCODE_R)
+                        ++mandelbrotData.max_iterations;
+                    else if (scancode == SDL_SCANCODE_E)
+                        if (mandelbrotData.max_iterations > 0) --mandelbrotData.max_iterations;
+
+                    if (scancode == SDL_SCANCODE_P)
+                        display_options.overlay = !display_options.overlay;
+                    if (scancode == SDL_SCANCODE_H)
+                        display_options.heatmap = !display_options.heatmap;
+                    if (scancode == SDL_SCANCODE_C)
+                        display_options.equalize = !display_options.equalize;
+                    if (scancode == SDL_SCANCODE_F)
+                        display_options.variant.fp64 = !display_options.variant.fp64;
+                    if (scancode == SDL_SCANCODE_B)
+                        display_options.variant.distance_estimation = !display_options.variant.distance_estimation;
+                    if (scancode == SDL_SCANCODE_I)
+                        display_options.variant.interior_detection = !display_options.variant.interior_detection;
+                    if (scancode == SDL_SCANCODE_M)
+                        display_options.variant.formula = ::next_formula(display_options.variant.formula);
+                    if (scancode == SDL_SCANCODE_J)
+                        display_options.julia = !display_options.julia;
+
+                    if (scancode == SDL_SCANCODE_F12)
+                        ++display_options.screenshots;
+
+                    if (scancode == SDL_SCANCODE_T)
+                    {
+                        if (::tracing())
+                        {
+                            ::set_tracing(false);
+                            ::write_trace(trace_file);
+                        }
+                        else
+                            ::set_tracing(true);
+                    }
+
+                    break;
+                }
+                case SDL_MOUSEMOTION:
+                    display_options.pointer_x = event.motion.x;
+                    display_options.pointer_y = event.motion.y;
+                    if (display_options.julia && !first_input)
+                        first_input = std::max<Uint32>(event.motion.timestamp, 1);
+                break;
+                case SDL_QUIT:
+                    running = false;
+                break;
+            }
+        }
+
+        return first_input;
+    }
+
+    // Square pixels, two units of scale from the bottom to the top of the window, centred where
+    // the left third of the window used to end.
+    Viewport view_viewport(const MandelbrotData& mandelbrot_data)
+    {
+        return {HighPrecision::from_double(mandelbrot_data.x - 0.5 * mandelbrot_data.scale),
+                HighPrecision::from_double(mandelbrot_data.y),
+                2.0 * mandelbrot_data.scale / WINDOW_HEIGHT, WINDOW_WIDTH, WINDOW_HEIGHT};
+    }
+
+    // The point of the viewport at the centre of window pixel (x, y), counted from the top left.
+    std::pair<double, double> window_point(const Viewport& viewport, int x, int y)
+    {
+        return {viewport.center_x.to_double() + (x + 0.5 - 0.5 * viewport.width) * viewport.pixel_size,
+                viewport.center_y.to_double() + (0.5 * viewport.height - y - 0.5) * viewport.pixel_size};
+    }
 
-        ::glBindBuffer(GL_ARRAY_BUFFER, buffer);
-        ::glBufferData(GL_ARRAY_BUFFER, sizeof(rectangle_data), rectangle_data, GL_STATIC_DRAW);
-        ::glBindBuffer(GL_ARRAY_BUFFER, 0);
+    GLprogram create_program(ProgramCache* cache, const ShaderFiles& files)
+    {
+        return ::create_shader_program(cache, ::vertex_shader_source(files), ::fragment_shader_source(files));
+    }
 
-        return buffer;
+    // Tiles on disk are only reused by the same iteration shader.
+    std::string tile_backend(const std::string& iteration_source_hash)
+    {
+        return "gl-" + iteration_source_hash;
     }
 
-    GLobject create_rectangle_vertex_array_object(const GLobject& rectangle_buffer)
+    // GL objects and per-frame state shared by the viewer and replay; needs a current context.
+    struct RenderPipeline
     {
-        GLobject vertex_array_object
+        GLvertex_array vertex_array_object;
+        GLprogram iteration_program;
+        GLprogram downsample_program;
+        GLprogram color_program;
+        GLprogram julia_program;    // built once the preview is first shown
+        GLtexture palette;
+
+        std::unique_ptr<ProgramCache> program_cache;
+        std::unique_ptr<DiskCache> disk_cache;
+        ShaderFiles iteration_files;
+        ShaderFiles julia_files;
+        std::string backend;
+        TilePyramid tile_pyramid;
+        GpuTimer gpu_timer;
+        ComputeScheduler compute_scheduler;
+        IterationStatistics iteration_statistics;
+        HistogramEqualizer histogram_equalizer;
+        JuliaPreview julia_preview;
+
+        RenderPipeline(std::unique_ptr<DiskCache> cache, std::unique_ptr<ProgramCache> programs, double compute_budget,
+                       const Palette& palette_colors, const ShaderFiles& iteration, double julia_budget) :
+            vertex_array_object{::create_vertex_array_object()},
+            iteration_program{::create_program(programs.get(), iteration)},
+            downsample_program{::create_program(programs.get(), PROGRAM_FILES[DOWNSAMPLE_PROGRAM])},
+            color_program{::create_program(programs.get(), PROGRAM_FILES[COLOR_PROGRAM])},
+            palette{::create_palette_texture(static_cast<GLsizei>(palette_colors.size()), palette_colors.front().data())},
+            program_cache{std::move(programs)},
+            disk_cache{std::move(cache)},
+            iteration_files{iteration},
+            julia_files{PROGRAM_FILES[JULIA_PROGRAM]},
+            backend{::tile_backend(::program_source_hash(iteration))},
+            tile_pyramid{pyramid_programs(), backend, disk_cache.get(), GPU_TILE_CAPACITY},
+            gpu_timer{PASS_COUNT},
+            compute_scheduler{compute_budget},
+            histogram_equalizer{::create_compute_program(::shader_source("equalize_shader.comp"))},
+            julia_preview{WINDOW_WIDTH, WINDOW_HEIGHT, julia_budget}
         {
-            []
+            // nothing else uses the unit, so the palette stays bound
+            ::glBindTextureUnit(PALETTE_UNIT, palette);
+        }
+
+        PyramidPrograms pyramid_programs() const
+        {
+            return {iteration_program, downsample_program, color_program, vertex_array_object,
+                    ::iteration_precision(iteration_files)};
+        }
+
+        void replace_program(std::size_t index, GLprogram program, const std::string& source_hash)
+        {
+            if      (index == ITERATION_PROGRAM)
+            {
+                iteration_program = std::move(program);
+                backend = ::tile_backend(source_hash);
+            }
+            else if (index == DOWNSAMPLE_PROGRAM)
+                downsample_program = std::move(program);
+            else if (index == COLOR_PROGRAM)
+                color_program = std::move(program);
+            else if (index == JULIA_PROGRAM)
             {
-                GLuint vertex_array_object;
-                ::glGenVertexArrays(1, &vertex_array_object);
+                julia_program = std::move(program);
+                julia_preview.set_iteration_program(julia_program);
+            }
 
-                if (!vertex_array_object)
-                    throw std::runtime_error{"vertex array object generation error"};
+            tile_pyramid.set_programs(pyramid_programs(), backend);
+        }
 
-                return vertex_array_object;
+        // Switches to another permutation of the iteration shader, built synchronously; the batch
+        // sizes adapt to its cost by themselves.
+        void select_iteration_program(const ShaderFiles& files)
+        {
+            if (files == iteration_files)
+                return;
 
-            }(), [](GLuint vertex_array_object) {::glDeleteVertexArrays(1, &vertex_array_object);}
-        };
+            const TraceScope trace{"select_iteration_program"};
 
-        ::glBindVertexArray(vertex_array_object);
-        ::glBindBuffer(GL_ARRAY_BUFFER, rectangle_buffer);
-        ::glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), nullptr);
-        ::glEnableVertexAttribArray(0);
-        ::glBindBuffer(GL_ARRAY_BUFFER, 0);
-        ::glBindVertexArray(0);
+            iteration_files = files;
+            replace_program(ITERATION_PROGRAM, ::create_program(program_cache.get(), files), ::program_source_hash(files));
+        }
 
-        return vertex_array_object;
-    }
+        void select_julia_program(const ShaderFiles& files)
+        {
+            if (julia_program && files == julia_files)
+                return;
 
-    GLobject create_shader(const std::string& source, GLenum shader_type)
+            const TraceScope trace{"select_julia_program"};
+
+            julia_files = files;
+            julia_program = ::create_program(program_cache.get(), files);
+            julia_preview.set_iteration_program(julia_program);
+            // the preview binds it through the pyramid, which must not take it for the one replaced
+            tile_pyramid.set_programs(pyramid_programs(), backend);
+        }
+    };
+
+    void render(const MandelbrotData& mandelbrot_data, const DisplayOptions& display_options, RenderPipeline& pipeline)
     {
-        GLobject shader
+        const TraceScope trace{"render"};
+
+        const Viewport viewport{::view_viewport(mandelbrot_data)};
+
+        pipeline.select_iteration_program(::iteration_files(display_options.variant));
+
+        pipeline.gpu_timer.begin(TILE_PASS);
+        pipeline.tile_pyramid.update(viewport, mandelbrot_data.max_iterations, pipeline.compute_scheduler);
+        pipeline.gpu_timer.end();
+
+        const ColorOptions color_options{display_options.heatmap,
+                                         display_options.heatmap && pipeline.iteration_statistics.begin_frame(),
+                                         display_options.equalize && !display_options.heatmap,
+                                         ::uses_distance_estimation(display_options.variant)};
+
+        pipeline.gpu_timer.begin(COLOR_PASS);
+        pipeline.tile_pyramid.draw(viewport, color_options);
+        if (color_options.equalize)
+            pipeline.histogram_equalizer.update(pipeline.color_program);
+        pipeline.gpu_timer.end();
+
+        if (color_options.statistics)
+            pipeline.iteration_statistics.end_frame();
+
+        if (display_options.julia)
         {
-            [shader_type]
+            pipeline.select_julia_program(::julia_files(display_options.variant));
+
+            // the parameter stays put while the pointer is over the preview itself
+            const int x = display_options.pointer_x;
+            const int y = display_options.pointer_y;
+            if (x >= 0 && !pipeline.julia_preview.covers(x, y))
             {
-                const GLuint shader = ::glCreateShader(shader_type);
-                if (!shader)
-                    throw std::runtime_error{"shader creation error"};
+                const std::pair<double, double> parameter{::window_point(viewport, x, y)};
+                pipeline.julia_preview.set_parameter(parameter.first, parameter.second);
+            }
 
-                return shader;
+            pipeline.gpu_timer.begin(JULIA_PASS);
+            pipeline.julia_preview.draw(pipeline.tile_pyramid, mandelbrot_data.max_iterations,
+                                        {display_options.heatmap, false, false, color_options.distance_estimation});
+            pipeline.gpu_timer.end();
+        }
+    }
 
-            }(), [](GLuint shader) {::glDeleteShader(shader);}
-        };
+    std::string statistics_summary(const IterationTotals& totals)
+    {
+        const double pixels = static_cast<double>(std::max<std::uint64_t>(totals.pixels, 1));
+
+        std::ostringstream summary;
+        summary << std::fixed << std::setprecision(1)
+                << totals.iterations * 1e-6 << "M iterations, " << 100.0 * totals.max_pixels / pixels << "% at max, "
+                << 100.0 * totals.skipped_pixels / pixels << "% early-out";
+        if (totals.interior_pixels)
+            summary << ", " << 100.0 * totals.interior_pixels / pixels << "% interior detected, "
+                    << totals.saved_iterations * 1e-6 << "M iterations saved ("
+                    << 100.0 * totals.saved_iterations / static_cast<double>(totals.iterations + totals.saved_iterations)
+                    << "%)";
+        return summary.str();
+    }
 
-        const char* const source_cstr = source.c_str();
-        ::glShaderSource(shader, 1, &source_cstr, nullptr);
-        ::glCompileShader(shader);
-        
-        GLint status;
-        ::glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
-        if (status == GL_FALSE)
-            throw std::runtime_error{"shader compilation error"};
+    std::string timing_summary(const RenderPipeline& pipeline, const FrameTimes& frame_times)
+    {
+        const GpuTimer& gpu_timer = pipeline.gpu_timer;
+
+        std::ostringstream summary;
+        summary << std::fixed << std::setprecision(2)
+                << "gpu " << gpu_timer.frame_milliseconds() << " ms (tiles " << gpu_timer.pass_milliseconds(TILE_PASS)
+                << ", color " << gpu_timer.pass_milliseconds(COLOR_PASS) << ", julia "
+                << gpu_timer.pass_milliseconds(JULIA_PASS) << ", "
+                << pipeline.compute_scheduler.tile_milliseconds() << " per new tile), cpu " << frame_times.cpu_time.mean()
+                << " ms, frame " << frame_times.interval.mean() << " ms, input to photon "
+                << frame_times.input_latency.mean() << " ms";
+        return summary.str();
+    }
 
-        return shader;
+    std::unique_ptr<DiskCache> make_disk_cache(const Arguments& arguments)
+    {
+        if (arguments.has("no-disk-cache"))
+            return nullptr;
+
+        const TraceScope trace{"open_disk_cache"};
+        return std::make_unique<DiskCache>(arguments.string_value("cache-dir", DiskCache::default_directory()),
+                                           static_cast<std::uintmax_t>(arguments.unsigned_value("cache-size", 512)) << 20);
+    }
+
+    Palette palette_setting(const Arguments& arguments)
+    {
+        return arguments.has("palette") ? ::load_palette(arguments.string_value("palette", "")) : ::default_palette();
     }
 
-    GLobject create_shader_program(const std::string& vertex_shader_source, const std::string& fragment_shader_source)
+    IterationVariant iteration_variant(const Arguments& arguments)
     {
-        GLobject shader_program
+        return {::parse_formula(arguments.string_value("formula", "mandelbrot")), arguments.has("fp64"),
+                arguments.has("distance-estimation"), arguments.has("interior-detection")};
+    }
+
+    // Program binaries are tiny next to tiles and stay outside the disk cache's size budget.
+    std::unique_ptr<ProgramCache> make_program_cache(const Arguments& arguments)
+    {
+        if (arguments.has("no-program-cache"))
+            return nullptr;
+
+        try
         {
-            []
-            {
-                const GLuint shader_program = ::glCreateProgram();
-                if (!shader_program)
-                    throw std::runtime_error{"shader program creation error"};
+            return std::make_unique<ProgramCache>(arguments.string_value("cache-dir", DiskCache::default_directory()) +
+                                                  "/programs");
+        }
+        catch (const std::exception& ex)
+        {
+            std::cerr << "program cache: " << ex.what() << std::endl;
+            return nullptr;
+        }
+    }
 
-                return shader_program;
+    AnimationSettings animation_settings(const Arguments& arguments)
+    {
+        const std::pair<int, int> size = arguments.size_value("size", {WINDOW_WIDTH, WINDOW_HEIGHT});
 
-            }(), [](GLuint shader_program) {::glDeleteProgram(shader_program);}
-        };
+        return {arguments.view_value("from"), arguments.view_value("to"),
+                arguments.unsigned_value("frames", 300), arguments.unsigned_value("iterations", 1000),
+                size.first, size.second, arguments.string_value("output", "frame_"), arguments.has("equalize")};
+    }
 
-        const GLobject vertex_shader{::create_shader(vertex_shader_source, GL_VERTEX_SHADER)};
-        const GLobject fragment_shader{::create_shader(fragment_shader_source, GL_FRAGMENT_SHADER)};
+    unsigned short port_value(const Arguments& arguments)
+    {
+        const unsigned port = arguments.unsigned_value("port", 8080);
+        if (port == 0 || port > 65535)
+            throw std::runtime_error{"invalid value for --port: " + std::to_string(port)};
 
-        ::glAttachShader(shader_program, vertex_shader);
-        ::glAttachShader(shader_program, fragment_shader);
-        ::glLinkProgram(shader_program);
+        return static_cast<unsigned short>(port);
+    }
 
-        GLint status;
-        ::glGetProgramiv(shader_program, GL_LINK_STATUS, &status);
-        if (status == GL_FALSE)
-            throw std::runtime_error{"failed to link shader program"};
+    TileServerSettings tile_server_settings(const Arguments& arguments)
+    {
+        return {::port_value(arguments), arguments.unsigned_value("threads", 0), arguments.unsigned_value("iterations", 1000),
+                static_cast<int>(arguments.unsigned_value("tile-size", 256)), arguments.unsigned_value("cache-tiles", 4096),
+                arguments.has("distance-estimation"), ::parse_formula(arguments.string_value("formula", "mandelbrot"))};
+    }
 
-        ::glDetachShader(shader_program, vertex_shader);
-        ::glDetachShader(shader_program, fragment_shader);
+    LoadTestSettings load_test_settings(const Arguments& arguments)
+    {
+        return {arguments.string_value("host", "127.0.0.1"), ::port_value(arguments),
+                arguments.unsigned_value("requests", 1000), arguments.unsigned_value("concurrency", 16),
+                arguments.unsigned_value("zoom", 6), arguments.unsigned_value("distinct", 64)};
+    }
 
-        return shader_program;
+    CoordinatorSettings coordinator_settings(const Arguments& arguments)
+    {
+        const std::pair<int, int> size = arguments.size_value("size", {WINDOW_WIDTH, WINDOW_HEIGHT});
+        const View view{arguments.view_value("view")};
+        const Precision precision{arguments.has("precision") ? ::parse_precision(arguments.string_value("precision", "")) :
+                                  ::default_precision(::make_viewport(view, size.first, size.second).pixel_size)};
+
+        return {::port_value(arguments), view, size.first, size.second, arguments.unsigned_value("iterations", 1000),
+                precision, static_cast<int>(arguments.unsigned_value("job-size", 256)),
+                arguments.unsigned_value("timeout", 30), arguments.string_value("output", "image.ppm"),
+                arguments.has("equalize")};
     }
 
-    std::string read_file(const std::string& file_path)
+    WorkerSettings worker_settings(const Arguments& arguments)
     {
-        std::ifstream stream{file_path, std::ios::in};
-        if (!stream)
-            throw std::runtime_error{"file reading error"};
+        return {arguments.string_value("host", "127.0.0.1"), ::port_value(arguments),
+                arguments.unsigned_value("threads", 0), arguments.unsigned_value("connect-timeout", 10)};
+    }
 
-        return {std::istreambuf_iterator<char>{stream}, std::istreambuf_iterator<char>{}};
+    BenchmarkSettings benchmark_settings(const Arguments& arguments)
+    {
+        const std::pair<int, int> size = arguments.size_value("size", {640, 480});
+
+        return {size.first, size.second, arguments.unsigned_value("repeat", 3), arguments.unsigned_value("threads", 0)};
     }
 
-    void do_events(MandelbrotData& mandelbrotData, bool& running) noexcept
+    // Writes whatever is still being recorded, from --trace or a T press in the viewer.
+    void finish_trace(const Arguments& arguments)
     {
-        static SDL_Event event;
+        if (::tracing())
+            ::write_trace(arguments.string_value("trace", "trace.json"));
+    }
 
-        while (::SDL_PollEvent(&event))
+    // Runs body with a window and a GL 4.5 core context, current on the calling thread. Body must leave
+    // it current there again. Errors are reported, not thrown.
+    int run_with_window(Uint32 window_flags, const std::function<void(SDL_Window*, SDL_GLContext)>& body)
+    {
+        int status = 1;
+
+        if (::SDL_Init(SDL_INIT_VIDEO) >= 0)
         {
-            switch (event.type)
+            ::SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+            ::SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+            ::SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 5);
+            ::SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+
+            SDL_Window* const window = ::SDL_CreateWindow("MandelbrotGL",
+                    SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, WINDOW_WIDTH, WINDOW_HEIGHT, SDL_WINDOW_OPENGL | window_flags);
+            if (window)
             {
-                case SDL_KEYDOWN:
+                const SDL_GLContext gl_context = ::SDL_GL_CreateContext(window);
+                if (gl_context)
                 {
-                    const SDL_Scancode scancode = event.key.keysym.scancode;
+                    ::glewExperimental = GL_TRUE;
+                    ::glewInit();
 
-                    const float scale_per = 0.1F * mandelbrotData.scale;
+                    try
+                    {
+                        body(window, gl_context);
+                        status = 0;
+                    }
+                    catch(const std::exception& ex)
+                    {
+                        std::cerr << ex.what() << std::endl;
+                    }
 
-                    if      (scancode == SDL_SCANCODE_W)
-                        mandelbrotData.y += scale_per;
-                    else if (scancode == SDL_SCANCODE_S)
-                        mandelbrotData.y -= scale_per;
+                    ::SDL_GL_DeleteContext(gl_context);
+                }
+                else
+                    std::cerr << "SDL_GLContext creation error: " << ::SDL_GetError() << std::endl;
 
-                    if      (scancode == SDL_SCANCODE_A)
-                        mandelbrotData.x -= scale_per;
-                    else if (scancode == SDL_SCANCODE_D)
-                        mandelbrotData.x += scale_per;
+                ::SDL_DestroyWindow(window);
+            }
+            else
+                std::cerr << "SDL_Window creation error: " << ::SDL_GetError() << std::endl;
 
-                    if      (scancode == SDL_SCANCODE_Z)
-                        mandelbrotData.scale -= scale_per;
-                    else if (scancode == SDL_SCANCODE_X)
-                        mandelbrotData.scale += scale_per;
+            ::SDL_Quit();
+        }
+        else
+            std::cerr << "SDL2 initialization error: " << ::SDL_GetError() << std::endl;
 
-                    if      (scancode == SDL_SCANCODE_R)
-                        ++mandelbrotData.max_iterations;
-                    else if (scancode == SDL_SCANCODE_E)
-                        if (mandelbrotData.max_iterations > 0) --mandelbrotData.max_iterations;
+        return status;
+    }
 
-                    break;
-                }
-                case SDL_QUIT:
-                    running = false;
-                break;
-            }
+    // Adaptive vsync (late swaps tear instead of waiting a whole period) where the driver has it.
+    int set_swap_interval(bool vsync)
+    {
+        if (!vsync)
+        {
+            ::SDL_GL_SetSwapInterval(0);
+            return 0;
         }
+
+        if (::SDL_GL_SetSwapInterval(-1) == 0)
+            return -1;
+        if (::SDL_GL_SetSwapInterval(1) == 0)
+            return 1;
+
+        return 0;
     }
 
-    void render(const MandelbrotData& mandelbrot_data, const RenderData& render_data) noexcept
+    double refresh_period(SDL_Window* window)
     {
-        ::glClear(GL_COLOR_BUFFER_BIT);
+        SDL_DisplayMode mode;
+        if (::SDL_GetWindowDisplayMode(window, &mode) == 0 && mode.refresh_rate > 0)
+            return 1.0 / mode.refresh_rate;
 
-        ::glUseProgram(render_data.shader_program);
-        ::glUniform1f(0, WINDOW_WIDTH);
-        ::glUniform1f(1, WINDOW_HEIGHT);
-        ::glUniform2f(2, -2.0F * mandelbrot_data.scale + mandelbrot_data.x,
-                          1.0F * mandelbrot_data.scale + mandelbrot_data.x);
-        ::glUniform2f(3, -1.0F * mandelbrot_data.scale + mandelbrot_data.y,
-                          1.0F * mandelbrot_data.scale + mandelbrot_data.y);
-        ::glUniform1ui(4, mandelbrot_data.max_iterations);
+        return DEFAULT_FRAME_PERIOD;
+    }
 
-        ::glBindVertexArray(render_data.vertex_array_object);
-        ::glDrawArrays(GL_TRIANGLES, 0, 6);
-        ::glBindVertexArray(0);
+    void post_title(ViewerChannel& channel, std::string title)
+    {
+        const std::lock_guard<std::mutex> lock{channel.title_mutex};
+        channel.title = std::move(title);
+        channel.title_changed = true;
+    }
 
-        ::glUseProgram(0);
+    // Copies the back buffer without waiting for the GPU. Once the copy landed its rows are copied
+    // out of the mapping, and writer writes the file.
+    void take_screenshot(ReadbackRing& screenshots, ThreadPool& writer, const std::string& file_path)
+    {
+        constexpr std::size_t row_size = WINDOW_WIDTH * 3;
+        constexpr GLsizeiptr size = row_size * WINDOW_HEIGHT;
+
+        screenshots.read_pixels(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, GL_RGB, GL_UNSIGNED_BYTE, size,
+                                [&writer, file_path](const void* data)
+                                {
+                                    const std::uint8_t* const pixels = static_cast<const std::uint8_t*>(data);
+                                    std::vector<std::uint8_t> rgb(size);
+                                    for (std::size_t row = 0; row < WINDOW_HEIGHT; ++row)
+                                        std::copy_n(pixels + (WINDOW_HEIGHT - 1 - row) * row_size, row_size,
+                                                    &rgb[row * row_size]);
+
+                                    writer.submit([file_path, rgb = std::move(rgb)]
+                                                  {
+                                                      const TraceScope trace{"write_screenshot"};
+
+                                                      try
+                                                      {
+                                                          ::write_ppm(file_path, WINDOW_WIDTH, WINDOW_HEIGHT, rgb);
+                                                          std::cerr << "screenshot: " << file_path << std::endl;
+                                                      }
+                                                      catch (const std::exception& ex)
+                                                      {
+                                                          std::cerr << "screenshot: " << ex.what() << std::endl;
+                                                      }
+                                                  });
+                                });
     }
-}
 
-int main()
-{
-    if (::SDL_Init(SDL_INIT_VIDEO) >= 0)
+    // Render thread body: takes the latest state as late as possible, right after the pacer's wait,
+    // and never touches the event queue.
+    void render_frames(SDL_Window* window, const Arguments& arguments, ViewerChannel& channel)
     {
-        ::SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-        ::SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
-        ::SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 5);
-        ::SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+        using clock = std::chrono::steady_clock;
+
+        const clock::time_point pipeline_started = clock::now();
+        RenderPipeline pipeline{::make_disk_cache(arguments), ::make_program_cache(arguments),
+                                arguments.double_value("compute-budget", DEFAULT_COMPUTE_BUDGET), ::palette_setting(arguments),
+                                ::iteration_files(::iteration_variant(arguments)),
+                                arguments.double_value("julia-budget", DEFAULT_JULIA_BUDGET)};
+        const double pipeline_time = std::chrono::duration<double, std::milli>(clock::now() - pipeline_started).count();
+        bool first_frame = true;
+
+        FrameTimes frame_times;
+        FrameGraph frame_graph;
+
+        // without vsync frames are only paced if asked to
+        const bool vsync = !arguments.has("no-vsync");
+        const int swap_interval = ::set_swap_interval(vsync);
+        const double max_fps = arguments.double_value("max-fps", 0.0);
+        FramePacer frame_pacer{vsync ? ::refresh_period(window) : max_fps > 0.0 ? 1.0 / max_fps : 0.0};
+
+        std::cerr << "vsync: " << (swap_interval < 0 ? "adaptive" : swap_interval ? "on" : "off") << std::endl;
+
+        const double log_interval = arguments.double_value("log-interval", 5.0);
+        clock::time_point last_log = clock::now();
+        clock::time_point last_title = last_log;
+        clock::time_point frame_started = last_log;
+
+        // only files in an override directory can change while running
+        std::unique_ptr<ShaderReloader> shader_reloader;
+        if (!::shader_directory().empty())
+        {
+            shader_reloader = std::make_unique<ShaderReloader>(::shader_directory());
+            for (const ShaderFiles& files : PROGRAM_FILES)
+                shader_reloader->watch(files);
+            shader_reloader->rewatch(ITERATION_PROGRAM, pipeline.iteration_files);
+        }
+
+        ViewerState state{};
+        channel.state.take(state);
+
+        ThreadPool screenshot_writer{1};    // before the ring, whose last completions still submit to it
+        ReadbackRing screenshots{WINDOW_WIDTH * WINDOW_HEIGHT * 3};
+        const std::string screenshot_prefix{arguments.string_value("screenshot-prefix", "screenshot_")};
+        unsigned screenshots_taken = state.display_options.screenshots;
 
-        SDL_Window* const window = ::SDL_CreateWindow("MandelbrotGL",
-                SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, WINDOW_WIDTH, WINDOW_HEIGHT, SDL_WINDOW_OPENGL);
-        if (window)
+        while (channel.running)
         {
-            const SDL_GLContext gl_context = ::SDL_GL_CreateContext(window);
-            if (gl_context)
             {
-                ::glewExperimental = GL_TRUE;
-                ::glewInit();
+                const TraceScope wait_trace{"wait"};
+                frame_pacer.wait();
+            }
 
-                try
-                {
-                    const GLobject rectangle_buffer{::create_rectangle_buffer()};
-                    const GLobject rectangle_vertex_array_object{
-                                ::create_rectangle_vertex_array_object(rectangle_buffer)};
+            const TraceScope frame_trace{"frame"};
 
-                    const GLobject shader_program{::create_shader_program(::read_file("res/mandelbrot_shader.vs"),
-                                                                          ::read_file("res/mandelbrot_shader.fs"))};
+            const clock::time_point previous_started = frame_started;
+            frame_started = clock::now();
+            frame_times.interval.add(std::chrono::duration<double, std::milli>(frame_started - previous_started).count());
 
-                    MandelbrotData mandelbrot_data{1.0F, 0.0F, 0.0F, 30};
-                    const RenderData render_data{shader_program, rectangle_vertex_array_object};
+            pipeline.gpu_timer.begin_frame();
 
-                    bool running = true;
-                    while (running)
-                    {
-                        ::do_events(mandelbrot_data, running);
-                        ::render(mandelbrot_data, render_data);
+            const DisplayOptions& display_options = state.display_options;
+            const bool titled = display_options.overlay || display_options.heatmap;
+            channel.state.take(state);
+            const Uint32 input_time = channel.first_input.exchange(0);
 
-                        ::SDL_GL_SwapWindow(window);
-                        ::SDL_Delay(30);
-                    }
-                }
-                catch(const std::exception& ex)
+            if (shader_reloader)
+                shader_reloader->poll([&pipeline](std::size_t index, GLprogram program, const std::string& source_hash)
+                                      {pipeline.replace_program(index, std::move(program), source_hash);});
+
+            ::render(state.mandelbrot_data, display_options, pipeline);
+            if (shader_reloader && shader_reloader->get_files(ITERATION_PROGRAM) != pipeline.iteration_files)
+                shader_reloader->rewatch(ITERATION_PROGRAM, pipeline.iteration_files);
+            if (shader_reloader && shader_reloader->get_files(JULIA_PROGRAM) != pipeline.julia_files)
+                shader_reloader->rewatch(JULIA_PROGRAM, pipeline.julia_files);
+
+            // before the overlay, so that only the picture ends up in the file
+            screenshots.poll();
+            if (display_options.screenshots != screenshots_taken)
+            {
+                screenshots_taken = display_options.screenshots;
+                ::take_screenshot(screenshots, screenshot_writer, screenshot_prefix + std::to_string(screenshots_taken) + ".ppm");
+            }
+
+            const clock::time_point submitted = clock::now();
+            const double cpu_time = std::chrono::duration<double, std::milli>(submitted - frame_started).count();
+            frame_times.cpu_time.add(cpu_time);
+            frame_graph.add(cpu_time, pipeline.gpu_timer.last_frame_milliseconds());
+
+            if (display_options.overlay)
+            {
+                const TraceScope overlay_trace{"overlay"};
+                frame_graph.draw();
+            }
+
+            if (display_options.overlay || display_options.heatmap)
+            {
+                if (std::chrono::duration<double>(submitted - last_title).count() >= TITLE_INTERVAL)
                 {
-                    std::cerr << ex.what() << std::endl;
+                    std::string title{"MandelbrotGL"};
+                    if (display_options.overlay)
+                        title += " | " + ::timing_summary(pipeline, frame_times);
+                    if (display_options.heatmap)
+                        title += " | " + ::statistics_summary(pipeline.iteration_statistics.get_latest());
+
+                    ::post_title(channel, std::move(title));
+                    last_title = submitted;
                 }
+            }
+            else if (titled)
+                ::post_title(channel, "MandelbrotGL");
+
+            if (log_interval > 0.0 && std::chrono::duration<double>(submitted - last_log).count() >= log_interval)
+            {
+                std::cerr << ::timing_summary(pipeline, frame_times) << std::endl;
+                last_log = submitted;
+            }
+
+            const double work = std::chrono::duration<double>(clock::now() - frame_started).count() +
+                                pipeline.gpu_timer.last_frame_milliseconds() * 1e-3;
+            {
+                const TraceScope swap_trace{"swap"};
+                ::SDL_GL_SwapWindow(window);
+            }
+            frame_pacer.presented(work);
+
+            if (input_time)
+                frame_times.input_latency.add(static_cast<double>(::SDL_GetTicks() - input_time));
+
+            if (first_frame)
+            {
+                std::cerr << std::fixed << std::setprecision(1) << "startup: pipeline " << pipeline_time
+                          << " ms, first frame " << std::chrono::duration<double, std::milli>(clock::now() - LAUNCHED).count()
+                          << " ms after launch" << std::endl;
+                first_frame = false;
+            }
+        }
+
+        screenshots.finish();
+    }
+
+    void render_thread(SDL_Window* window, SDL_GLContext gl_context, const Arguments& arguments, ViewerChannel& channel)
+    {
+        if (::SDL_GL_MakeCurrent(window, gl_context) != 0)
+        {
+            channel.error = std::make_exception_ptr(std::runtime_error{std::string{"cannot make the GL context current: "} +
+                                                                       ::SDL_GetError()});
+            channel.running = false;
+            return;
+        }
+
+        try
+        {
+            ::render_frames(window, arguments, channel);
+        }
+        catch (...)
+        {
+            channel.error = std::current_exception();
+            channel.running = false;
+        }
+
+        ::SDL_GL_MakeCurrent(window, nullptr);
+    }
+
+    // The calling thread only handles events: bursts of key presses are folded into one target state,
+    // which the render thread picks up whenever it starts its next frame, so a slow frame never delays
+    // event handling and a fast one never waits for it.
+    void view(SDL_Window* window, SDL_GLContext gl_context, const Arguments& arguments)
+    {
+        std::unique_ptr<InputRecorder> recorder;
+        if (arguments.has("record"))
+            recorder = std::make_unique<InputRecorder>(arguments.string_value("record", ""));
+
+        const std::string trace_file{arguments.string_value("trace", "trace.json")};
+
+        ViewerState state{{1.0, 0.0, 0.0, 30}, {arguments.has("overlay"), arguments.has("heatmap"),
+                                                    arguments.has("equalize"), ::iteration_variant(arguments),
+                                                    arguments.has("julia"), -1, -1, 0}};
+        ViewerChannel channel;
+        channel.state.publish(state);
+
+        // a context is current on at most one thread
+        ::SDL_GL_MakeCurrent(window, nullptr);
+        std::thread renderer{[&] {::render_thread(window, gl_context, arguments, channel);}};
+
+        while (channel.running)
+        {
+            ::SDL_WaitEventTimeout(nullptr, EVENT_TIMEOUT);
+
+            bool running = true;
+            const Uint32 input_time = ::do_events(state.mandelbrot_data, state.display_options, trace_file, running);
+            if (!running)
+                channel.running = false;
+
+            if (input_time)
+            {
+                if (recorder)
+                    recorder->record(state.mandelbrot_data);
+
+                // published first: a frame may then count a press late, never early
+                channel.state.publish(state);
+                Uint32 none = 0;
+                channel.first_input.compare_exchange_strong(none, input_time);
+            }
+
+            std::unique_lock<std::mutex> lock{channel.title_mutex};
+            if (channel.title_changed)
+            {
+                const std::string title{std::move(channel.title)};
+                channel.title_changed = false;
+                lock.unlock();
 
-                ::SDL_GL_DeleteContext(gl_context);
+                ::SDL_SetWindowTitle(window, title.c_str());
             }
+        }
+
+        renderer.join();
+        ::SDL_GL_MakeCurrent(window, gl_context);
+
+        if (channel.error)
+            std::rethrow_exception(channel.error);
+    }
+
+    // Feeds a recording through the render pipeline in a hidden window. Frame latency runs from
+    // the start of a frame until glFinish() returns. In real time, frames are paced at 60 Hz and
+    // inputs applied at their recorded times; otherwise every input gets one frame, back to back.
+    // The disk cache stays off so that runs do not depend on earlier ones; cached programs only shorten startup.
+    void replay(const Arguments& arguments)
+    {
+        const std::vector<RecordedInput> inputs{::load_recording(arguments.string_value("input", ""))};
+        const bool real_time = arguments.has("real-time");
+
+        RenderPipeline pipeline{nullptr, ::make_program_cache(arguments),
+                                arguments.double_value("compute-budget", DEFAULT_COMPUTE_BUDGET), ::palette_setting(arguments),
+                                ::iteration_files(::iteration_variant(arguments)),
+                                arguments.double_value("julia-budget", DEFAULT_JULIA_BUDGET)};
+        const DisplayOptions display_options{false, arguments.has("heatmap"), arguments.has("equalize"),
+                                             ::iteration_variant(arguments), arguments.has("julia"), -1, -1, 0};
+
+        FramePacer frame_pacer{real_time ? DEFAULT_FRAME_PERIOD : 0.0};
+
+        using clock = std::chrono::steady_clock;
+        std::vector<double> latencies;
+        const clock::time_point started = clock::now();
+
+        MandelbrotData mandelbrot_data{inputs.front().data};
+        for (std::size_t next = 0; next < inputs.size();)
+        {
+            {
+                const TraceScope wait_trace{"wait"};
+                frame_pacer.wait();
+            }
+
+            const TraceScope frame_trace{"frame"};
+
+            const clock::time_point frame_started = clock::now();
+            const double elapsed = std::chrono::duration<double>(frame_started - started).count();
+
+            if (real_time)
+                for (; next < inputs.size() && inputs[next].time <= elapsed; ++next)
+                    mandelbrot_data = inputs[next].data;
             else
-                std::cerr << "SDL_GLContext creation error: " << ::SDL_GetError() << std::endl;
+                mandelbrot_data = inputs[next++].data;
 
-            ::SDL_DestroyWindow(window);
+            pipeline.gpu_timer.begin_frame();
+            ::render(mandelbrot_data, display_options, pipeline);
+            ::glFinish();
+
+            const double latency = std::chrono::duration<double>(clock::now() - frame_started).count();
+            latencies.push_back(latency * 1e3);
+            frame_pacer.presented(latency);
+        }
+
+        const double seconds = std::chrono::duration<double>(clock::now() - started).count();
+
+        std::sort(latencies.begin(), latencies.end());
+        const auto percentile = [&latencies](double p) {return latencies[static_cast<std::size_t>(p * (latencies.size() - 1))];};
+
+        std::cout << std::fixed << std::setprecision(2)
+                  << "inputs:     " << inputs.size() << " over " << inputs.back().time << " s recorded\n"
+                  << "frames:     " << latencies.size() << " in " << seconds << " s\n"
+                  << "latency ms: p50 " << percentile(0.5) << ", p90 " << percentile(0.9)
+                  << ", p99 " << percentile(0.99) << ", max " << latencies.back() << std::endl;
+    }
+
+    int run_viewer(const Arguments& arguments)
+    {
+        return ::run_with_window(0, [&arguments](SDL_Window* window, SDL_GLContext gl_context)
+                                    {::view(window, gl_context, arguments);});
+    }
+
+    int run_replay(const Arguments& arguments)
+    {
+        return ::run_with_window(SDL_WINDOW_HIDDEN, [&arguments](SDL_Window*, SDL_GLContext) {::replay(arguments);});
+    }
+
+    // The CPU kernels and, in a hidden window, the plain Mandelbrot iteration shader the viewer's tiles
+    // run; --no-gl leaves the GPU out, e.g. without a display.
+    int run_bench(const Arguments& arguments)
+    {
+        if (arguments.has("no-gl"))
+        {
+            std::cerr << "bench: --no-gl, the iteration shader is not measured" << std::endl;
+            ::run_benchmark(::benchmark_settings(arguments), std::cout);
+            return 0;
+        }
+
+        return ::run_with_window(SDL_WINDOW_HIDDEN, [&arguments](SDL_Window*, SDL_GLContext)
+                                 {
+                                     const std::unique_ptr<ProgramCache> program_cache{::make_program_cache(arguments)};
+                                     const GLprogram fp32_program{::create_program(program_cache.get(),
+                                             ::iteration_files({Formula::mandelbrot, false, false, false}))};
+                                     const GLprogram fp64_program{::create_program(program_cache.get(),
+                                             ::iteration_files({Formula::mandelbrot, true, false, false}))};
+
+                                     GpuBenchmark gpu_benchmark{fp32_program, fp64_program};
+                                     ::run_benchmark(::benchmark_settings(arguments), std::cout,
+                                                     [&gpu_benchmark](const Viewport& viewport, unsigned max_iterations, Precision precision)
+                                                     {return gpu_benchmark.render(viewport, max_iterations, precision);});
+                                 });
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        const Arguments arguments{argc, argv};
+        ::set_tracing(arguments.has("trace"));
+        if (arguments.has("shader-dir"))
+            ::set_shader_directory(arguments.string_value("shader-dir", "res"));
+
+        if (arguments.get_mode().empty())
+        {
+            const int status = ::run_viewer(arguments);
+            ::finish_trace(arguments);
+            return status;
+        }
+
+        if (arguments.get_mode() == "animate")
+        {
+            const std::unique_ptr<DiskCache> disk_cache{::make_disk_cache(arguments)};
+            ::render_animation(::animation_settings(arguments), disk_cache.get());
+        }
+        else if (arguments.get_mode() == "serve")
+        {
+            const std::unique_ptr<DiskCache> disk_cache{::make_disk_cache(arguments)};
+            TileServer{::tile_server_settings(arguments), disk_cache.get()}.run();
+        }
+        else if (arguments.get_mode() == "loadtest")
+            ::run_load_test(::load_test_settings(arguments));
+        else if (arguments.get_mode() == "coordinate")
+        {
+            const std::unique_ptr<DiskCache> disk_cache{::make_disk_cache(arguments)};
+            ::run_coordinator(::coordinator_settings(arguments), disk_cache.get());
+        }
+        else if (arguments.get_mode() == "work")
+            ::run_worker(::worker_settings(arguments));
+        else if (arguments.get_mode() == "bench")
+        {
+            const int status = ::run_bench(arguments);
+            ::finish_trace(arguments);
+            return status;
+        }
+        else if (arguments.get_mode() == "replay")
+        {
+            const int status = ::run_replay(arguments);
+            ::finish_trace(arguments);
+            return status;
         }
         else
-            std::cerr << "SDL_Window creation error: " << ::SDL_GetError() << std::endl;
+            throw std::runtime_error{"unknown mode: " + arguments.get_mode()};
 
-        ::SDL_Quit();
+        ::finish_trace(arguments);
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        return 1;
     }
-    else
-        std::cerr << "SDL2 initialization error: " << ::SDL_GetError() << std::endl;
 
     return 0;
 }
@@ -0,0 +1,24 @@
+#ifndef MANDELBROT_DATA_HPP
+#define MANDELBROT_DATA_HPP
+
+// View state of the interactive viewer, changed by its key bindings. Doubles, so that the centre
+// can be placed as finely as the fp64 iteration shader resolves.
+struct MandelbrotData
+{
+    double scale;
+    double x;
+    double y;
+    unsigned max_iterations;
+};
+
+inline bool operator==(const MandelbrotData& a, const MandelbrotData& b) noexcept
+{
+    return a.scale == b.scale && a.x == b.x && a.y == b.y && a.max_iterations == b.max_iterations;
+}
+
+inline bool operator!=(const MandelbrotData& a, const MandelbrotData& b) noexcept
+{
+    return !(a == b);
+}
+
+#endif
@@ -0,0 +1,58 @@
+#include "palette.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+Palette default_palette()
+{
+    return
+    {
+        {0.0F,  0.0F,  0.0F},
+        {0.26F, 0.18F, 0.06F},
+        {0.1F,  0.03F, 0.1F},
+        {0.04F, 0.0F,  0.18F},
+        {0.02F, 0.02F, 0.29F},
+        {0.0F,  0.03F, 0.39F},
+        {0.05F, 0.17F, 0.54F},
+        {0.09F, 0.32F, 0.69F},
+        {0.22F, 0.49F, 0.82F},
+        {0.52F, 0.71F, 0.9F},
+        {0.82F, 0.92F, 0.97F},
+        {0.94F, 0.91F, 0.75F},
+        {0.97F, 0.79F, 0.37F},
+        {1.0F,  0.67F, 0.0F},
+        {0.8F,  0.5F,  0.0F},
+        {0.6F,  0.34F, 0.0F},
+        {0.41F, 0.2F,  0.01F}
+    };
+}
+
+Palette load_palette(const std::string& file_path)
+{
+    std::ifstream stream{file_path, std::ios::in};
+    if (!stream)
+        throw std::runtime_error{"cannot read " + file_path};
+
+    Palette palette;
+    std::string line;
+    for (unsigned number = 1; std::getline(stream, line); ++number)
+    {
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::istringstream fields{line};
+        std::array<float, 3> color;
+        std::string rest;
+        if (!(fields >> color[0] >> color[1] >> color[2]) || (fields >> rest) ||
+            color[0] < 0.0F || color[0] > 1.0F || color[1] < 0.0F || color[1] > 1.0F || color[2] < 0.0F || color[2] > 1.0F)
+            throw std::runtime_error{file_path + ':' + std::to_string(number) + ": malformed color"};
+
+        palette.push_back(color);
+    }
+
+    if (palette.size() < 2)
+        throw std::runtime_error{file_path + " needs at least two colors"};
+
+    return palette;
+}
@@ -0,0 +1,17 @@
+#ifndef PALETTE_HPP
+#define PALETTE_HPP
+
+#include <array>
+#include <vector>
+#include <string>
+
+// Evenly spaced colors of a cyclic gradient, components in [0, 1].
+using Palette = std::vector<std::array<float, 3>>;
+
+// The 17 colors the renderers have always used.
+Palette default_palette();
+
+// One "r g b" color per line; blank lines and lines starting with # are skipped.
+Palette load_palette(const std::string& file_path);
+
+#endif
@@ -0,0 +1,147 @@
+#include "program_cache.hpp"
+#include "file_system.hpp"
+#include "shaders.hpp"
+#include "trace.hpp"
+
+#include <unistd.h>
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+
+namespace
+{
+    const std::string MAGIC = "MBPB";
+    const std::string SUFFIX = ".bin";
+
+    std::string gl_string(GLenum name)
+    {
+        const GLubyte* const value = ::glGetString(name);
+        return value ? reinterpret_cast<const char*>(value) : "";
+    }
+
+    // Returns 0 if the binary is missing, foreign or rejected by the driver.
+    GLuint load_program(const std::string& file_path, const std::string& key)
+    {
+        const TraceScope trace{"load_program_binary"};
+
+        std::ifstream stream{file_path, std::ios::in | std::ios::binary};
+        if (!stream)
+            return 0;
+
+        const std::string contents{std::istreambuf_iterator<char>{stream}, std::istreambuf_iterator<char>{}};
+
+        const std::size_t header_size = MAGIC.size() + key.size() + 1 + sizeof(GLenum);
+        if (contents.size() <= header_size || contents.compare(0, MAGIC.size(), MAGIC) != 0 ||
+            contents.compare(MAGIC.size(), key.size() + 1, key + '\0') != 0)
+            return 0;
+
+        GLenum format;
+        std::memcpy(&format, contents.data() + header_size - sizeof(GLenum), sizeof(GLenum));
+
+        const GLuint program = ::glCreateProgram();
+        if (!program)
+            return 0;
+
+        ::glProgramBinary(program, format, contents.data() + header_size, static_cast<GLsizei>(contents.size() - header_size));
+
+        GLint status;
+        ::glGetProgramiv(program, GL_LINK_STATUS, &status);
+        if (status == GL_FALSE)
+        {
+            std::cerr << "program cache: " << file_path << " rejected by the driver, recompiling" << std::endl;
+            ::glDeleteProgram(program);
+            return 0;
+        }
+
+        return program;
+    }
+
+    void store_program(const std::string& file_path, const std::string& key, GLuint program)
+    {
+        GLint length = 0;
+        ::glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+            return;
+
+        std::vector<char> binary(static_cast<std::size_t>(length));
+        GLenum format;
+        ::glGetProgramBinary(program, length, &length, &format, binary.data());
+
+        std::string contents{MAGIC + key + '\0'};
+        contents.append(reinterpret_cast<const char*>(&format), sizeof(format));
+        contents.append(binary.data(), static_cast<std::size_t>(length));
+
+        // written aside and renamed, so that a concurrent run never loads half a binary
+        const std::string temporary = file_path + ".tmp" + std::to_string(::getpid());
+        {
+            std::ofstream stream{temporary, std::ios::out | std::ios::binary};
+            stream.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+            if (!stream)
+                throw std::runtime_error{"cannot write " + temporary};
+        }
+        if (std::rename(temporary.c_str(), file_path.c_str()) != 0)
+        {
+            std::remove(temporary.c_str());
+            throw std::runtime_error{"cannot rename " + temporary + ": " + std::strerror(errno)};
+        }
+    }
+}
+
+ProgramCache::ProgramCache(const std::string& directory) : directory{directory}
+{
+    ::make_directories(directory);
+}
+
+GLprogram ProgramCache::create_program(const std::string& vertex_shader_source, const std::string& fragment_shader_source)
+{
+    if (driver.empty())
+    {
+        GLint format_count = 0;
+        ::glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+
+        // some drivers support the calls but no format at all
+        if (format_count <= 0)
+            return ::create_shader_program(vertex_shader_source, fragment_shader_source);
+
+        driver = ::gl_string(GL_VENDOR) + '\n' + ::gl_string(GL_RENDERER) + '\n' + ::gl_string(GL_VERSION);
+    }
+
+    const std::string key{driver + '\n' + ::shader_hash(vertex_shader_source) + ::shader_hash(fragment_shader_source)};
+    const std::string file_path{directory + '/' + ::shader_hash(key) + SUFFIX};
+
+    if (const GLuint program = ::load_program(file_path, key))
+        return GLprogram{program};
+
+    GLprogram program{[&]
+    {
+        const TraceScope trace{"compile_program"};
+        return ::create_shader_program(vertex_shader_source, fragment_shader_source, true);
+    }()};
+
+    try
+    {
+        ::store_program(file_path, key, program);
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << "program cache: " << ex.what() << std::endl;
+    }
+
+    return program;
+}
+
+GLprogram create_shader_program(ProgramCache* cache, const std::string& vertex_shader_source,
+                               const std::string& fragment_shader_source)
+{
+    if (cache)
+        return cache->create_program(vertex_shader_source, fragment_shader_source);
+
+    const TraceScope trace{"compile_program"};
+    return ::create_shader_program(vertex_shader_source, fragment_shader_source);
+}
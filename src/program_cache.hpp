@@ -0,0 +1,28 @@
+#ifndef PROGRAM_CACHE_HPP
+#define PROGRAM_CACHE_HPP
+
+#include "gl_resources.hpp"
+
+#include <string>
+
+// Keeps linked shader programs on disk (glGetProgramBinary) so that later runs skip compilation.
+// Binaries are keyed by the driver's vendor, renderer and version strings plus a hash of the
+// sources. A binary the driver rejects anyway, e.g. after an update that kept the version string,
+// is compiled from source again and replaced.
+class ProgramCache
+{
+    std::string directory;
+    std::string driver;     // queried on first use, when a context is current
+
+public:
+    explicit ProgramCache(const std::string& directory);
+
+    // Needs a current context. Cache failures are reported on stderr, compile errors thrown.
+    GLprogram create_program(const std::string& vertex_shader_source, const std::string& fragment_shader_source);
+};
+
+// Without a cache, programs are just compiled.
+GLprogram create_shader_program(ProgramCache* cache, const std::string& vertex_shader_source,
+                               const std::string& fragment_shader_source);
+
+#endif
@@ -0,0 +1,118 @@
+#include "readback_ring.hpp"
+#include "trace.hpp"
+
+#include <stdexcept>
+
+ReadbackRing::ReadbackRing(GLsizeiptr slot_size, std::size_t slot_count) :
+    slot_size{slot_size}, buffer{::create_readback_buffer(slot_size * static_cast<GLsizeiptr>(slot_count))},
+    mapping{static_cast<const char*>(::glMapNamedBufferRange(buffer, 0, slot_size * static_cast<GLsizeiptr>(slot_count),
+                                                              GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT))},
+    slots(slot_count)
+{
+    if (!slot_count)
+        throw std::runtime_error{"readback ring needs at least one slot"};
+    if (!mapping)
+        throw std::runtime_error{"readback buffer mapping error"};
+}
+
+ReadbackRing::~ReadbackRing()
+{
+    for (Slot& slot : slots)
+        if (slot.fence)
+            ::glDeleteSync(slot.fence);
+
+    ::glUnmapNamedBuffer(buffer);
+}
+
+void ReadbackRing::complete(Slot& slot)
+{
+    const completion done{std::move(slot.done)};
+    const std::size_t index = static_cast<std::size_t>(&slot - slots.data());
+
+    ::glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+    slot.done = nullptr;
+
+    done(mapping + index * static_cast<std::size_t>(slot_size));
+}
+
+std::size_t ReadbackRing::acquire()
+{
+    Slot& slot = slots[next];
+    if (slot.fence)
+    {
+        const TraceScope trace{"readback_stall"};
+
+        // the ring is full: the oldest copy has to land first
+        ::glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        complete(slot);
+    }
+
+    ::glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+    ::glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    return next;
+}
+
+void ReadbackRing::submit(std::size_t index, completion done)
+{
+    ::glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slots[index].fence = ::glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slots[index].done = std::move(done);
+
+    next = (next + 1) % slots.size();
+}
+
+void ReadbackRing::read_texture(GLuint texture, GLenum format, GLenum type, GLsizeiptr size, completion done)
+{
+    if (size > slot_size)
+        throw std::runtime_error{"readback larger than a slot"};
+
+    const std::size_t index = acquire();
+    ::glGetTextureImage(texture, 0, format, type, static_cast<GLsizei>(size),
+                        reinterpret_cast<void*>(index * static_cast<std::size_t>(slot_size)));
+    submit(index, std::move(done));
+}
+
+void ReadbackRing::read_pixels(int x, int y, int width, int height, GLenum format, GLenum type, GLsizeiptr size,
+                               completion done)
+{
+    if (size > slot_size)
+        throw std::runtime_error{"readback larger than a slot"};
+
+    const std::size_t index = acquire();
+    ::glReadnPixels(x, y, width, height, format, type, static_cast<GLsizei>(size),
+                    reinterpret_cast<void*>(index * static_cast<std::size_t>(slot_size)));
+    submit(index, std::move(done));
+}
+
+void ReadbackRing::poll()
+{
+    // slots are handed out in order, so the oldest copy in flight follows next
+    for (std::size_t offset = 0; offset < slots.size(); ++offset)
+    {
+        Slot& slot = slots[(next + offset) % slots.size()];
+        if (!slot.fence)
+            continue;
+
+        const GLenum status = ::glClientWaitSync(slot.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+
+        complete(slot);
+    }
+}
+
+void ReadbackRing::finish()
+{
+    for (std::size_t offset = 0; offset < slots.size(); ++offset)
+    {
+        Slot& slot = slots[(next + offset) % slots.size()];
+        if (!slot.fence)
+            continue;
+
+        ::glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        complete(slot);
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef READBACK_RING_HPP
+#define READBACK_RING_HPP
+
+#include "gl_resources.hpp"
+
+#include <vector>
+#include <functional>
+#include <cstddef>
+
+// Asynchronous GPU to CPU copies. One pixel pack buffer, persistently mapped, is split into equal
+// slots used in turn; a copy into a slot is followed by a fence, and its completion runs from a
+// later poll() once the fence has signalled, reading straight from the mapping. Nothing waits on
+// the GPU unless every slot is still in flight, in which case the oldest copy is waited for.
+class ReadbackRing
+{
+public:
+    // data points into the mapping and is valid only during the call.
+    using completion = std::function<void(const void* data)>;
+
+private:
+    struct Slot
+    {
+        GLsync fence = nullptr;
+        completion done;
+    };
+
+    GLsizeiptr slot_size;
+    GLbuffer buffer;
+    const char* mapping;
+    std::vector<Slot> slots;
+    std::size_t next = 0;
+
+    void complete(Slot& slot);
+    // Binds the pack buffer and returns the slot's offset into it.
+    std::size_t acquire();
+    void submit(std::size_t slot, completion done);
+
+public:
+    ReadbackRing(GLsizeiptr slot_size, std::size_t slot_count = 3);
+    ReadbackRing(const ReadbackRing&) = delete;
+    ~ReadbackRing();
+
+    ReadbackRing& operator=(const ReadbackRing&) = delete;
+
+    // Level 0 of texture; size is the byte size of the image, at most slot_size.
+    void read_texture(GLuint texture, GLenum format, GLenum type, GLsizeiptr size, completion done);
+    // From the framebuffer bound for reading, rows bottom-up and tightly packed.
+    void read_pixels(int x, int y, int width, int height, GLenum format, GLenum type, GLsizeiptr size,
+                     completion done);
+
+    // Runs the completions of the copies that have finished, oldest first.
+    void poll();
+    // Waits for every copy in flight and runs its completion.
+    void finish();
+};
+
+#endif
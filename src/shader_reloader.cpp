@@ -0,0 +1,215 @@
+#include "shader_reloader.hpp"
+#include "shaders.hpp"
+#include "trace.hpp"
+
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+
+namespace
+{
+    GLshader start_shader(const std::string& source, GLenum shader_type)
+    {
+        GLshader shader{::glCreateShader(shader_type)};
+        if (!shader)
+            throw std::runtime_error{"shader creation error"};
+
+        const char* const source_cstr = source.c_str();
+        ::glShaderSource(shader, 1, &source_cstr, nullptr);
+        ::glCompileShader(shader);
+
+        return shader;
+    }
+
+    std::string shader_log(GLuint shader)
+    {
+        GLint length = 0;
+        ::glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+
+        std::string log(static_cast<std::size_t>(std::max(length, 1)), '\0');
+        ::glGetShaderInfoLog(shader, length, nullptr, &log[0]);
+        log.resize(std::strlen(log.c_str()));
+
+        return log;
+    }
+
+    std::string program_log(GLuint program)
+    {
+        GLint length = 0;
+        ::glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+
+        std::string log(static_cast<std::size_t>(std::max(length, 1)), '\0');
+        ::glGetProgramInfoLog(program, length, nullptr, &log[0]);
+        log.resize(std::strlen(log.c_str()));
+
+        return log;
+    }
+}
+
+bool operator==(const ShaderFiles& a, const ShaderFiles& b)
+{
+    return a.vertex_shader == b.vertex_shader && a.fragment_shader == b.fragment_shader && a.defines == b.defines;
+}
+
+bool operator!=(const ShaderFiles& a, const ShaderFiles& b)
+{
+    return !(a == b);
+}
+
+std::string vertex_shader_source(const ShaderFiles& files)
+{
+    return ::specialized_source(::shader_source(files.vertex_shader), files.defines);
+}
+
+std::string fragment_shader_source(const ShaderFiles& files)
+{
+    return ::specialized_source(::shader_source(files.fragment_shader), files.defines);
+}
+
+std::string program_source_hash(const ShaderFiles& files)
+{
+    return ::shader_hash(::vertex_shader_source(files)) + ::shader_hash(::fragment_shader_source(files));
+}
+
+ShaderReloader::ShaderReloader(const std::string& directory) :
+    descriptor{::inotify_init1(IN_NONBLOCK | IN_CLOEXEC)},
+    parallel{GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile}
+{
+    if (descriptor < 0)
+        throw std::runtime_error{std::string{"inotify: "} + std::strerror(errno)};
+
+    // editors either rewrite a file in place or rename a new one over it
+    if (::inotify_add_watch(descriptor, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        const int error = errno;
+        ::close(descriptor);
+        throw std::runtime_error{"cannot watch " + directory + ": " + std::strerror(error)};
+    }
+
+    if (GLEW_KHR_parallel_shader_compile)
+        ::glMaxShaderCompilerThreadsKHR(0xFFFFFFFFU);
+    else if (GLEW_ARB_parallel_shader_compile)
+        ::glMaxShaderCompilerThreadsARB(0xFFFFFFFFU);
+}
+
+ShaderReloader::~ShaderReloader()
+{
+    ::close(descriptor);
+}
+
+std::size_t ShaderReloader::watch(const ShaderFiles& files)
+{
+    entries.push_back({files, nullptr, false});
+    return entries.size() - 1;
+}
+
+void ShaderReloader::rewatch(std::size_t index, const ShaderFiles& files)
+{
+    entries[index].files = files;
+    entries[index].build.reset();
+}
+
+void ShaderReloader::read_events()
+{
+    alignas(inotify_event) char buffer[4096];
+
+    for (;;)
+    {
+        const ssize_t size = ::read(descriptor, buffer, sizeof(buffer));
+        if (size <= 0)
+            break;
+
+        for (ssize_t offset = 0; offset < size;)
+        {
+            const inotify_event* const event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+            if (!event->len)
+                continue;
+
+            for (Entry& entry : entries)
+                if (entry.files.vertex_shader == event->name || entry.files.fragment_shader == event->name)
+                    entry.changed = true;
+        }
+    }
+}
+
+void ShaderReloader::poll(const swap_function& swap)
+{
+    read_events();
+
+    for (std::size_t index = 0; index < entries.size(); ++index)
+    {
+        Entry& entry = entries[index];
+
+        // a newer edit supersedes the build in flight
+        if (entry.changed)
+        {
+            const TraceScope trace{"start_shader_build"};
+
+            entry.changed = false;
+            entry.build.reset();
+
+            try
+            {
+                const std::string vertex_source{::vertex_shader_source(entry.files)};
+                const std::string fragment_source{::fragment_shader_source(entry.files)};
+
+                GLshader vertex_shader{::start_shader(vertex_source, GL_VERTEX_SHADER)};
+                GLshader fragment_shader{::start_shader(fragment_source, GL_FRAGMENT_SHADER)};
+                GLprogram program{::glCreateProgram()};
+                if (!program)
+                    throw std::runtime_error{"shader program creation error"};
+
+                ::glAttachShader(program, vertex_shader);
+                ::glAttachShader(program, fragment_shader);
+                ::glLinkProgram(program);
+
+                entry.build.reset(new Build{std::move(vertex_shader), std::move(fragment_shader), std::move(program),
+                                            ::shader_hash(vertex_source) + ::shader_hash(fragment_source)});
+            }
+            catch (const std::exception& ex)
+            {
+                std::cerr << "shader reload: " << entry.files.fragment_shader << ": " << ex.what() << std::endl;
+            }
+        }
+
+        if (!entry.build)
+            continue;
+
+        Build& build = *entry.build;
+        if (parallel)
+        {
+            GLint complete = GL_FALSE;
+            ::glGetProgramiv(build.program, GL_COMPLETION_STATUS_KHR, &complete);
+            if (complete == GL_FALSE)
+                continue;
+        }
+
+        GLint status;
+        ::glGetProgramiv(build.program, GL_LINK_STATUS, &status);
+        if (status == GL_FALSE)
+        {
+            std::cerr << "shader reload: " << entry.files.vertex_shader << " + " << entry.files.fragment_shader
+                      << " failed, keeping the previous program\n"
+                      << ::shader_log(build.vertex_shader) << ::shader_log(build.fragment_shader)
+                      << ::program_log(build.program) << std::flush;
+        }
+        else
+        {
+            ::glDetachShader(build.program, build.vertex_shader);
+            ::glDetachShader(build.program, build.fragment_shader);
+
+            std::cerr << "shader reload: " << entry.files.vertex_shader << " + " << entry.files.fragment_shader
+                      << " swapped in" << std::endl;
+            swap(index, std::move(build.program), build.source_hash);
+        }
+
+        entry.build.reset();
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef SHADER_RELOADER_HPP
+#define SHADER_RELOADER_HPP
+
+#include "gl_resources.hpp"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+
+struct ShaderFiles
+{
+    std::string vertex_shader;      // names as passed to shader_source()
+    std::string fragment_shader;
+    std::vector<std::string> defines;   // for both, see specialized_source()
+};
+
+bool operator==(const ShaderFiles& a, const ShaderFiles& b);
+bool operator!=(const ShaderFiles& a, const ShaderFiles& b);
+
+// Watches the shader directory with inotify and rebuilds every program one of whose files was
+// written. Builds are submitted without waiting; with KHR_parallel_shader_compile the driver
+// compiles and links them on its own threads and poll() only picks up finished ones, otherwise
+// the first poll after a change blocks. A program is handed over only once it linked: after a
+// broken edit the compile log goes to stderr and the previous program stays in use.
+class ShaderReloader
+{
+    struct Build
+    {
+        GLshader vertex_shader;
+        GLshader fragment_shader;
+        GLprogram program;
+        std::string source_hash;
+    };
+
+    struct Entry
+    {
+        ShaderFiles files;
+        std::unique_ptr<Build> build;   // in flight
+        bool changed = false;
+    };
+
+    int descriptor;
+    bool parallel;
+    std::vector<Entry> entries;
+
+    void read_events();
+
+public:
+    // program is the linked replacement, source_hash identifies its sources.
+    using swap_function = std::function<void(std::size_t index, GLprogram program, const std::string& source_hash)>;
+
+    // Needs a current context.
+    explicit ShaderReloader(const std::string& directory);
+    ShaderReloader(const ShaderReloader&) = delete;
+    ~ShaderReloader();
+
+    ShaderReloader& operator=(const ShaderReloader&) = delete;
+
+    // Returns the index passed to swap for this program.
+    std::size_t watch(const ShaderFiles& files);
+    // Rebuilds the program at index from other files (or defines) from now on; a build in flight
+    // of the old ones is dropped.
+    void rewatch(std::size_t index, const ShaderFiles& files);
+    const ShaderFiles& get_files(std::size_t index) const noexcept {return entries[index].files;}
+    // Call once per frame on the context's thread.
+    void poll(const swap_function& swap);
+};
+
+// The sources of a program, specialized with its defines.
+std::string vertex_shader_source(const ShaderFiles& files);
+std::string fragment_shader_source(const ShaderFiles& files);
+// Identifies the sources of a program the way ShaderReloader does.
+std::string program_source_hash(const ShaderFiles& files);
+
+#endif
@@ -0,0 +1,71 @@
+#include "shaders.hpp"
+#include "gl_resources.hpp"
+#include "hash.hpp"
+#include "trace.hpp"
+
+#include <sys/stat.h>
+
+#include <cstring>
+#include <cstdio>
+#include <stdexcept>
+
+namespace
+{
+    std::string directory;
+}
+
+void set_shader_directory(const std::string& shader_directory)
+{
+    directory = shader_directory;
+}
+
+const std::string& shader_directory()
+{
+    return directory;
+}
+
+std::string shader_source(const std::string& name)
+{
+    const TraceScope trace{"shader_source"};
+
+    if (!directory.empty())
+    {
+        const std::string file_path{directory + '/' + name};
+
+        struct stat status;
+        if (::stat(file_path.c_str(), &status) == 0)
+            return ::read_file(file_path);
+    }
+
+    for (std::size_t i = 0; i < EMBEDDED_SHADER_COUNT; ++i)
+        if (std::strcmp(EMBEDDED_SHADERS[i].name, name.c_str()) == 0)
+            return EMBEDDED_SHADERS[i].source;
+
+    throw std::runtime_error{"unknown shader: " + name};
+}
+
+std::string specialized_source(const std::string& source, const std::vector<std::string>& defines)
+{
+    if (defines.empty())
+        return source;
+
+    const std::size_t newline = source.find('\n');
+    const std::size_t body = newline == std::string::npos ? source.size() : newline + 1;
+
+    std::string specialized{source, 0, body};
+    if (newline == std::string::npos)
+        specialized += '\n';
+    for (const std::string& define : defines)
+        specialized += "#define " + define + '\n';
+    specialized += "#line 2\n";
+    specialized.append(source, body, std::string::npos);
+
+    return specialized;
+}
+
+std::string shader_hash(const std::string& source)
+{
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(::fnv1a(source)));
+    return text;
+}
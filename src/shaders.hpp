@@ -0,0 +1,31 @@
+#ifndef SHADERS_HPP
+#define SHADERS_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+struct EmbeddedShader
+{
+    const char* name;       // file name under res/
+    const char* source;
+};
+
+// Generated from res/ by the Makefile.
+extern const EmbeddedShader EMBEDDED_SHADERS[];
+extern const std::size_t EMBEDDED_SHADER_COUNT;
+
+// Shader sources are compiled into the binary, so it starts without touching the file system.
+// While a directory is set, files found there take precedence, which lets shaders be edited
+// without rebuilding.
+void set_shader_directory(const std::string& directory);
+const std::string& shader_directory();
+
+std::string shader_source(const std::string& name);
+// source with "#define <define>" lines after its #version line, for permutations of one file; a #line
+// directive keeps compile errors pointing at the file's own line numbers.
+std::string specialized_source(const std::string& source, const std::vector<std::string>& defines);
+// 16 hex digits identifying a source, e.g. in cache keys.
+std::string shader_hash(const std::string& source);
+
+#endif
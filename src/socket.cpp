@@ -0,0 +1,156 @@
+#include "socket.hpp"
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    std::runtime_error socket_error(const std::string& what)
+    {
+        return std::runtime_error{what + ": " + std::strerror(errno)};
+    }
+
+    void disable_nagle(const Socket& socket) noexcept
+    {
+        const int enabled = 1;
+        ::setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &enabled, sizeof(enabled));
+    }
+}
+
+Socket::~Socket()
+{
+    if (descriptor >= 0)
+        ::close(descriptor);
+}
+
+Socket& Socket::operator=(Socket&& socket) noexcept
+{
+    if (this == &socket) return *this;
+
+    if (descriptor >= 0)
+        ::close(descriptor);
+
+    descriptor = socket.descriptor;
+    socket.descriptor = -1;
+
+    return *this;
+}
+
+Socket listen_socket(unsigned short port)
+{
+    Socket listener{::socket(AF_INET, SOCK_STREAM, 0)};
+    if (listener < 0)
+        throw ::socket_error("socket creation error");
+
+    const int enabled = 1;
+    ::setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &enabled, sizeof(enabled));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (::bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0)
+        throw ::socket_error("socket bind error");
+    if (::listen(listener, SOMAXCONN) < 0)
+        throw ::socket_error("socket listen error");
+
+    return listener;
+}
+
+Socket accept_connection(const Socket& listener)
+{
+    for (;;)
+    {
+        Socket connection{::accept(listener, nullptr, nullptr)};
+        if (connection >= 0)
+        {
+            ::disable_nagle(connection);
+            return connection;
+        }
+        // out of descriptors or memory: the listener is fine, the caller may try again later
+        if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM)
+            return connection;
+        if (errno != EINTR && errno != ECONNABORTED)
+            throw ::socket_error("socket accept error");
+    }
+}
+
+Socket connect_socket(const std::string& host, unsigned short port)
+{
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+
+    addrinfo* addresses = nullptr;
+    if (::getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0 || !addresses)
+        throw std::runtime_error{"cannot resolve " + host};
+
+    Socket connection{::socket(addresses->ai_family, addresses->ai_socktype, addresses->ai_protocol)};
+    const int result = connection < 0 ? -1 : ::connect(connection, addresses->ai_addr, addresses->ai_addrlen);
+    ::freeaddrinfo(addresses);
+
+    if (result < 0)
+        throw ::socket_error("cannot connect to " + host + ':' + std::to_string(port));
+
+    ::disable_nagle(connection);
+    return connection;
+}
+
+void set_timeouts(const Socket& socket, unsigned seconds)
+{
+    const timeval timeout{static_cast<time_t>(seconds), 0};
+    if (::setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0 ||
+        ::setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) != 0)
+        throw ::socket_error("socket option error");
+}
+
+void send_all(const Socket& socket, const void* data, std::size_t size)
+{
+    const char* bytes = static_cast<const char*>(data);
+    while (size)
+    {
+        const ssize_t sent = ::send(socket, bytes, size, MSG_NOSIGNAL);
+        if (sent < 0)
+        {
+            if (errno == EINTR) continue;
+            throw ::socket_error("socket send error");
+        }
+        bytes += sent;
+        size -= static_cast<std::size_t>(sent);
+    }
+}
+
+std::size_t receive_some(const Socket& socket, void* data, std::size_t size)
+{
+    for (;;)
+    {
+        const ssize_t received = ::recv(socket, data, size, 0);
+        if (received >= 0)
+            return static_cast<std::size_t>(received);
+        if (errno != EINTR)
+            throw ::socket_error("socket receive error");
+    }
+}
+
+void receive_all(const Socket& socket, void* data, std::size_t size)
+{
+    char* bytes = static_cast<char*>(data);
+    while (size)
+    {
+        const std::size_t received = ::receive_some(socket, bytes, size);
+        if (!received)
+            throw std::runtime_error{"connection closed by peer"};
+        bytes += received;
+        size -= received;
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef SOCKET_HPP
+#define SOCKET_HPP
+
+#include <string>
+#include <cstddef>
+
+// Owning wrapper around a POSIX socket descriptor.
+class Socket
+{
+    int descriptor;
+
+public:
+    explicit Socket(int descriptor = -1) noexcept : descriptor{descriptor} {}
+    Socket(const Socket&) = delete;
+    Socket(Socket&& socket) noexcept : descriptor{socket.descriptor}
+    {
+        socket.descriptor = -1;
+    }
+    ~Socket();
+
+    Socket& operator=(const Socket&) = delete;
+    Socket& operator=(Socket&& socket) noexcept;
+
+    operator int() const noexcept {return descriptor;}
+};
+
+// Listens on the loopback interface only.
+Socket listen_socket(unsigned short port);
+// An invalid socket (-1) while the process or system is out of descriptors or memory, with errno
+// telling which; throws if the listener itself is broken.
+Socket accept_connection(const Socket& listener);
+Socket connect_socket(const std::string& host, unsigned short port);
+// Sends and receives blocked for longer than seconds then fail with a socket error.
+void set_timeouts(const Socket& socket, unsigned seconds);
+
+void send_all(const Socket& socket, const void* data, std::size_t size);
+// Returns 0 once the peer has closed the connection.
+std::size_t receive_some(const Socket& socket, void* data, std::size_t size);
+void receive_all(const Socket& socket, void* data, std::size_t size);
+
+#endif
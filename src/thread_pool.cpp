@@ -0,0 +1,65 @@
+#include "thread_pool.hpp"
+
+#include <iostream>
+#include <exception>
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned thread_count)
+{
+    const unsigned count = std::max(1U, thread_count ? thread_count : std::thread::hardware_concurrency());
+
+    for (unsigned i = 0; i < count; ++i)
+        threads.emplace_back(&ThreadPool::work, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        const std::lock_guard<std::mutex> lock{mutex};
+        stopping = true;
+    }
+    condition.notify_all();
+
+    for (auto& thread : threads)
+        thread.join();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    {
+        const std::lock_guard<std::mutex> lock{mutex};
+        tasks.push_back(std::move(task));
+    }
+    condition.notify_one();
+}
+
+void ThreadPool::work()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock{mutex};
+            condition.wait(lock, [this] {return stopping || !tasks.empty();});
+
+            if (tasks.empty())
+                return;
+
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+
+        try
+        {
+            task();
+        }
+        catch (const std::exception& ex)
+        {
+            std::cerr << ex.what() << std::endl;
+        }
+        catch (...)
+        {
+            std::cerr << "unknown exception in thread pool task" << std::endl;
+        }
+    }
+}
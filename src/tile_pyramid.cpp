@@ -0,0 +1,472 @@
+#include "tile_pyramid.hpp"
+#include "trace.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    struct TileBounds
+    {
+        double left;
+        double right;
+        double bottom;
+        double top;
+    };
+
+    TileBounds tile_bounds(const TileCoordinates& tile, int tile_size)
+    {
+        const Viewport viewport{::tile_viewport(tile, tile_size)};
+        const double center_x = viewport.center_x.to_double();
+        const double center_y = viewport.center_y.to_double();
+        const double half = 0.5 * tile_size * viewport.pixel_size;
+
+        return {center_x - half, center_x + half, center_y - half, center_y + half};
+    }
+
+    std::string tile_key(const TileCoordinates& tile, int tile_size, unsigned max_iterations, const std::string& backend,
+                         Precision precision)
+    {
+        return DiskCache::key(DiskCache::viewport_bounds(::tile_viewport(tile, tile_size), backend), max_iterations, precision);
+    }
+
+    // disk reads queued per frame; the rest of the missing tiles are asked for on later frames
+    constexpr unsigned LOAD_BUDGET = 8;
+
+    // three frames of a typical compute budget; more tiles per frame wait for the oldest copy
+    constexpr std::size_t READBACK_SLOTS = 12;
+    constexpr GLsizeiptr TILE_BYTES = TilePyramid::TILE_SIZE * TilePyramid::TILE_SIZE * sizeof(std::uint32_t);
+
+    // GL rows run bottom-up, iteration buffers top-down.
+    IterationBuffer iteration_buffer(const void* data, int size)
+    {
+        const std::uint32_t* const pixels = static_cast<const std::uint32_t*>(data);
+
+        IterationBuffer buffer{size, size, std::vector<std::uint32_t>(static_cast<std::size_t>(size) * size)};
+        for (int row = 0; row < size; ++row)
+            std::copy_n(&pixels[static_cast<std::size_t>(size - 1 - row) * size], size,
+                        &buffer.iterations[static_cast<std::size_t>(row) * size]);
+
+        return buffer;
+    }
+
+    void upload_texture(const GLtexture& texture, const IterationBuffer& buffer)
+    {
+        std::vector<std::uint32_t> pixels(buffer.iterations.size());
+        for (int row = 0; row < buffer.height; ++row)
+            std::copy_n(&buffer.iterations[static_cast<std::size_t>(row) * buffer.width], buffer.width,
+                        &pixels[static_cast<std::size_t>(buffer.height - 1 - row) * buffer.width]);
+
+        ::glTextureSubImage2D(texture, 0, 0, 0, buffer.width, buffer.height, GL_RED_INTEGER, GL_UNSIGNED_INT, pixels.data());
+    }
+}
+
+TilePyramid::TilePyramid(const PyramidPrograms& programs, const std::string& backend, DiskCache* disk_cache,
+                         std::size_t capacity) :
+    programs{programs}, backend{backend}, disk_cache{disk_cache}, framebuffer{::create_framebuffer()},
+    view_buffer{::create_uniform_buffer(sizeof(ViewParameters))}, readbacks{TILE_BYTES, disk_cache ? READBACK_SLOTS : 1},
+    tiles{capacity}
+{
+    ::glBindBufferBase(GL_UNIFORM_BUFFER, VIEW_BINDING, view_buffer);
+    ::glNamedBufferSubData(view_buffer, 0, sizeof(ViewParameters), &view_parameters);
+    ::glBindVertexArray(programs.vertex_array_object);
+}
+
+TilePyramid::~TilePyramid()
+{
+    // tiles still on their way to the disk cache
+    readbacks.finish();
+}
+
+void TilePyramid::set_programs(const PyramidPrograms& programs, const std::string& backend)
+{
+    if (programs.iteration_program != this->programs.iteration_program ||
+        programs.downsample_program != this->programs.downsample_program)
+    {
+        tiles.clear();
+        partial.reset();
+        disk_misses.clear();
+    }
+
+    this->programs = programs;
+    this->backend = backend;
+
+    bound_program = 0;
+    ::glBindVertexArray(programs.vertex_array_object);
+}
+
+void TilePyramid::use_program(GLuint program)
+{
+    if (program == bound_program)
+        return;
+
+    ::glUseProgram(program);
+    bound_program = program;
+}
+
+void TilePyramid::set_view_parameters(const ViewParameters& parameters)
+{
+    if (std::memcmp(&parameters, &view_parameters, sizeof(ViewParameters)) == 0)
+        return;
+
+    view_parameters = parameters;
+    ::glNamedBufferSubData(view_buffer, 0, sizeof(ViewParameters), &view_parameters);
+}
+
+TilePyramid::tile_texture TilePyramid::find(const TileCoordinates& tile)
+{
+    tile_texture texture;
+    return tiles.get(::tile_name(tile), texture) ? texture : nullptr;
+}
+
+void TilePyramid::bind_target(const GLtexture& texture) const
+{
+    ::glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT0, texture, 0);
+
+    if (::glCheckNamedFramebufferStatus(framebuffer, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        throw std::runtime_error{"incomplete framebuffer"};
+
+    ::glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    ::glViewport(0, 0, TILE_SIZE, TILE_SIZE);
+}
+
+void TilePyramid::load_cached(const TileCoordinates& tile, const std::string& key)
+{
+    loading.insert(key);
+
+    disk_thread.submit([this, tile, key]
+                  {
+                      const TraceScope trace{"load_cached_tile"};
+
+                      LoadedTile result{tile, key, false, {}};
+                      result.found = disk_cache->load(key, result.buffer) &&
+                                     result.buffer.width == TILE_SIZE && result.buffer.height == TILE_SIZE;
+
+                      const std::lock_guard<std::mutex> lock{loaded_mutex};
+                      loaded.push_back(std::move(result));
+                  });
+}
+
+void TilePyramid::upload_loaded()
+{
+    std::vector<LoadedTile> answers;
+    {
+        const std::lock_guard<std::mutex> lock{loaded_mutex};
+        answers.swap(loaded);
+    }
+
+    for (LoadedTile& answer : answers)
+    {
+        loading.erase(answer.key);
+
+        if (!answer.found)
+        {
+            disk_misses.insert(answer.key);
+            continue;
+        }
+
+        // asked for by a replaced iteration shader or iteration count
+        if (answer.key != ::tile_key(answer.tile, TILE_SIZE, max_iterations, backend, programs.iteration_precision))
+            continue;
+
+        const TraceScope trace{"upload_cached_tile"};
+
+        const auto texture = std::make_shared<const GLtexture>(::create_iteration_texture(TILE_SIZE, TILE_SIZE));
+        ::upload_texture(*texture, answer.buffer);
+        tiles.put(::tile_name(answer.tile), texture);
+    }
+}
+
+TilePyramid::tile_texture TilePyramid::downsample(const TileCoordinates& tile)
+{
+    const TraceScope trace{"downsample_tile"};
+
+    if (tile.z == MAX_TILE_LEVEL)
+        return nullptr;
+
+    tile_texture children[2][2];
+    for (unsigned j = 0; j < 2; ++j)
+        for (unsigned i = 0; i < 2; ++i)
+            if (!(children[j][i] = find({tile.z + 1, tile.x * 2 + i, tile.y * 2 + j})))
+                return nullptr;
+
+    const auto texture = std::make_shared<const GLtexture>(::create_iteration_texture(TILE_SIZE, TILE_SIZE));
+    bind_target(*texture);
+
+    use_program(programs.downsample_program);
+    ::glUniform4f(6, 0.0F, 0.0F, 1.0F, 1.0F);
+
+    for (unsigned j = 0; j < 2; ++j)
+    {
+        for (unsigned i = 0; i < 2; ++i)
+        {
+            // child row 0 is the upper half, which is the upper half of NDC as well
+            ::glUniform4f(5, i ? 0.0F : -1.0F, j ? -1.0F : 0.0F, i ? 1.0F : 0.0F, j ? 0.0F : 1.0F);
+            ::glBindTextureUnit(0, *children[j][i]);
+            ::glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        }
+    }
+
+    ::glBindTextureUnit(0, 0);
+    ::glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    return texture;
+}
+
+TilePyramid::tile_texture TilePyramid::compute(const TileCoordinates& tile)
+{
+    const TraceScope trace{"compute_tile"};
+
+    const auto texture = std::make_shared<const GLtexture>(::create_iteration_texture(TILE_SIZE, TILE_SIZE));
+    compute_rows(tile, *texture, 0, TILE_SIZE);
+
+    return texture;
+}
+
+void TilePyramid::compute_rows(const TileCoordinates& tile, const GLtexture& texture, int first_row, int row_count)
+{
+    const TileBounds bounds = ::tile_bounds(tile, TILE_SIZE);
+
+    bind_target(texture);
+
+    use_program(programs.iteration_program);
+
+    ViewParameters parameters{};
+    parameters.area_w[0] = static_cast<GLfloat>(bounds.left);
+    parameters.area_w[1] = static_cast<GLfloat>(bounds.right);
+    parameters.area_h[0] = static_cast<GLfloat>(bounds.bottom);
+    parameters.area_h[1] = static_cast<GLfloat>(bounds.top);
+    parameters.precise_area_w[0] = bounds.left;
+    parameters.precise_area_w[1] = bounds.right;
+    parameters.precise_area_h[0] = bounds.bottom;
+    parameters.precise_area_h[1] = bounds.top;
+    parameters.target_size[0] = parameters.target_size[1] = TILE_SIZE;
+    parameters.max_iterations = max_iterations;
+    set_view_parameters(parameters);
+
+    const bool whole = first_row == 0 && row_count == TILE_SIZE;
+    if (!whole)
+    {
+        ::glEnable(GL_SCISSOR_TEST);
+        ::glScissor(0, first_row, TILE_SIZE, row_count);
+    }
+
+    ::glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    if (!whole)
+        ::glDisable(GL_SCISSOR_TEST);
+
+    ::glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+TilePyramid::tile_texture TilePyramid::compute_partial(const TileCoordinates& tile, double fraction)
+{
+    const TraceScope trace{"compute_tile_rows"};
+
+    if (!partial || partial->tile != tile)
+        partial.reset(new PartialTile{tile, std::make_shared<const GLtexture>(::create_iteration_texture(TILE_SIZE, TILE_SIZE)), 0});
+
+    // a single row more expensive than the whole budget still goes out whole
+    const int rows = std::min(TILE_SIZE - partial->rows_done, std::max(1, static_cast<int>(fraction * TILE_SIZE)));
+    compute_rows(tile, *partial->texture, partial->rows_done, rows);
+    partial->rows_done += rows;
+
+    if (partial->rows_done < TILE_SIZE)
+        return nullptr;
+
+    const tile_texture texture{partial->texture};
+    partial.reset();
+    return texture;
+}
+
+void TilePyramid::store(const TileCoordinates& tile, const GLtexture& texture)
+{
+    DiskCache* const cache = disk_cache;
+    ThreadPool* const writer = &disk_thread;
+    const std::string key{::tile_key(tile, TILE_SIZE, max_iterations, backend, programs.iteration_precision)};
+    disk_misses.erase(key);
+
+    // only the copy out of the mapping stays on this thread; encoding and writing do not
+    readbacks.read_texture(texture, GL_RED_INTEGER, GL_UNSIGNED_INT, TILE_BYTES,
+                           [cache, writer, key](const void* data)
+                           {
+                               writer->submit([cache, key, buffer = ::iteration_buffer(data, TILE_SIZE)]
+                                              {
+                                                  const TraceScope trace{"store_tile"};
+                                                  cache->store(key, buffer);
+                                              });
+                           });
+}
+
+void TilePyramid::update(const Viewport& viewport, unsigned max_iterations, ComputeScheduler& scheduler)
+{
+    const TraceScope trace{"update_tiles"};
+
+    readbacks.poll();
+
+    if (max_iterations != this->max_iterations)
+    {
+        tiles.clear();
+        partial.reset();
+        disk_misses.clear();
+        this->max_iterations = max_iterations;
+    }
+
+    upload_loaded();
+
+    const TileRange range = ::visible_tiles(viewport, ::tile_level(viewport.pixel_size, TILE_SIZE));
+
+    std::vector<TileCoordinates> missing;
+    for (std::uint64_t y = range.y0; y <= range.y1 && range.x0 <= range.x1; ++y)
+        for (std::uint64_t x = range.x0; x <= range.x1; ++x)
+            if (!find({range.z, x, y}))
+                missing.push_back({range.z, x, y});
+
+    const double center_x = viewport.center_x.to_double();
+    const double center_y = viewport.center_y.to_double();
+    const auto distance = [center_x, center_y](const TileCoordinates& tile)
+    {
+        const TileBounds bounds = ::tile_bounds(tile, TILE_SIZE);
+        const double dx = 0.5 * (bounds.left + bounds.right) - center_x;
+        const double dy = 0.5 * (bounds.bottom + bounds.top) - center_y;
+        return dx * dx + dy * dy;
+    };
+    std::sort(missing.begin(), missing.end(),
+              [&distance](const TileCoordinates& a, const TileCoordinates& b) {return distance(a) < distance(b);});
+
+    std::vector<TileCoordinates> uncomputed;
+    unsigned loads = 0;
+    for (const TileCoordinates& tile : missing)
+    {
+        if (disk_cache)
+        {
+            const std::string key{::tile_key(tile, TILE_SIZE, max_iterations, backend, programs.iteration_precision)};
+            if (!disk_misses.count(key))
+            {
+                if (!loading.count(key) && loads < LOAD_BUDGET)
+                {
+                    load_cached(tile, key);
+                    ++loads;
+                }
+                continue;
+            }
+        }
+
+        // downsampling reads the level below, so deferring the computes changes none of its results
+        if (const tile_texture texture{downsample(tile)})
+            tiles.put(::tile_name(tile), texture);
+        else
+            uncomputed.push_back(tile);
+    }
+
+    // a band left over from earlier batches is finished first, unless its tile went out of view
+    if (partial)
+    {
+        const auto found = std::find(uncomputed.begin(), uncomputed.end(), partial->tile);
+        if (found == uncomputed.end())
+            partial.reset();
+        else
+            std::rotate(uncomputed.begin(), found, found + 1);
+    }
+
+    if (!uncomputed.empty())
+    {
+        const double compute_budget = scheduler.begin_batch();
+
+        std::vector<tile_texture> computed;
+        if (compute_budget >= 1.0 && !partial)
+        {
+            uncomputed.resize(std::min<std::size_t>(static_cast<std::size_t>(compute_budget), uncomputed.size()));
+
+            for (const TileCoordinates& tile : uncomputed)
+                computed.push_back(compute(tile));
+            scheduler.end_batch(static_cast<double>(computed.size()));
+        }
+        else if (compute_budget > 0.0)
+        {
+            // the partial tile, if any, is at the front
+            const int rows_before = partial ? partial->rows_done : 0;
+            const tile_texture texture{compute_partial(uncomputed.front(), compute_budget)};
+            scheduler.end_batch(static_cast<double>((texture ? TILE_SIZE : partial->rows_done) - rows_before) / TILE_SIZE);
+
+            uncomputed.resize(texture ? 1 : 0);
+            if (texture)
+                computed.push_back(texture);
+        }
+        else
+        {
+            uncomputed.clear();
+        }
+
+        // the readbacks queue copies of their own, after the batch's closing timestamp
+        for (std::size_t i = 0; i < computed.size(); ++i)
+        {
+            if (disk_cache)
+                store(uncomputed[i], *computed[i]);
+            tiles.put(::tile_name(uncomputed[i]), computed[i]);
+        }
+    }
+
+    ::glViewport(0, 0, viewport.width, viewport.height);
+}
+
+void TilePyramid::draw(const Viewport& viewport, const ColorOptions& options)
+{
+    const TraceScope trace{"draw_tiles"};
+
+    const TileRange range = ::visible_tiles(viewport, ::tile_level(viewport.pixel_size, TILE_SIZE));
+
+    const double center_x = viewport.center_x.to_double();
+    const double center_y = viewport.center_y.to_double();
+    const double half_w = 0.5 * viewport.width  * viewport.pixel_size;
+    const double half_h = 0.5 * viewport.height * viewport.pixel_size;
+
+    ::glViewport(0, 0, viewport.width, viewport.height);
+    ::glClear(GL_COLOR_BUFFER_BIT);
+
+    use_program(programs.color_program);
+
+    ViewParameters parameters{};
+    parameters.target_size[0] = static_cast<GLfloat>(viewport.width);
+    parameters.target_size[1] = static_cast<GLfloat>(viewport.height);
+    parameters.max_iterations = max_iterations;
+    parameters.heatmap = options.heatmap;
+    parameters.collect_statistics = options.statistics;
+    parameters.equalize = options.equalize;
+    parameters.distance_estimation = options.distance_estimation;
+    set_view_parameters(parameters);
+
+    for (std::uint64_t y = range.y0; y <= range.y1 && range.x0 <= range.x1; ++y)
+    {
+        for (std::uint64_t x = range.x0; x <= range.x1; ++x)
+        {
+            // the tile itself, or the part of its nearest computed ancestor that covers it
+            tile_texture texture;
+            unsigned depth = 0;
+            for (; depth <= range.z && !(texture = find({range.z - depth, x >> depth, y >> depth})); ++depth);
+            if (!texture)
+                continue;
+
+            const TileBounds bounds = ::tile_bounds({range.z, x, y}, TILE_SIZE);
+            ::glUniform4f(5, static_cast<GLfloat>((bounds.left   - center_x) / half_w),
+                             static_cast<GLfloat>((bounds.bottom - center_y) / half_h),
+                             static_cast<GLfloat>((bounds.right  - center_x) / half_w),
+                             static_cast<GLfloat>((bounds.top    - center_y) / half_h));
+
+            const double fraction = std::ldexp(1.0, -static_cast<int>(depth));
+            const std::uint64_t mask = (1ULL << depth) - 1;
+            ::glUniform4f(6, static_cast<GLfloat>((x & mask) * fraction),
+                             static_cast<GLfloat>(1.0 - ((y & mask) + 1) * fraction),
+                             static_cast<GLfloat>(((x & mask) + 1) * fraction),
+                             static_cast<GLfloat>(1.0 - (y & mask) * fraction));
+
+            ::glBindTextureUnit(0, *texture);
+            ::glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        }
+    }
+
+    ::glBindTextureUnit(0, 0);
+}
@@ -0,0 +1,148 @@
+#ifndef TILE_PYRAMID_HPP
+#define TILE_PYRAMID_HPP
+
+#include "gl_resources.hpp"
+#include "tiles.hpp"
+#include "disk_cache.hpp"
+#include "lru_cache.hpp"
+#include "readback_ring.hpp"
+#include "thread_pool.hpp"
+#include "compute_scheduler.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <unordered_set>
+
+// The vertex array object has no attributes: every shader makes its vertices from gl_VertexID.
+struct PyramidPrograms
+{
+    GLuint iteration_program;
+    GLuint downsample_program;
+    GLuint color_program;
+    GLuint vertex_array_object;
+    Precision iteration_precision;  // fp32 or fp64, that of iteration_program's tiles in disk cache keys
+};
+
+// How TilePyramid::draw() turns tiles into colors.
+struct ColorOptions
+{
+    bool heatmap;               // iteration cost instead of the palette
+    bool statistics;            // count into the storage buffer bound at IterationStatistics::BINDING
+    bool equalize;              // through the CDF kept by HistogramEqualizer, counting into its histograms
+    bool distance_estimation;   // the tiles hold distance estimates, see mandelbrot_shader.fs
+};
+
+// Quadtree of GPU iteration tiles using the slippy-map addressing of tiles.hpp. Missing tiles are
+// produced lazily: from the disk cache, by downsampling four computed children, or by running the
+// escape-time shader, in that order. Disk reads run on a thread of their own, a few per frame, and a tile
+// waits for its answer before the other two are tried; keys found missing are not asked for again.
+// Until a tile exists its nearest computed ancestor is drawn upsampled in its place.
+class TilePyramid
+{
+public:
+    // std140 layout of the view block in the shaders
+    struct ViewParameters
+    {
+        GLfloat area_w[2];
+        GLfloat area_h[2];
+        GLfloat target_size[2];
+        GLuint max_iterations;
+        GLuint heatmap;
+        GLuint collect_statistics;
+        GLuint equalize;
+        GLuint distance_estimation;
+        GLuint padding;
+        GLdouble precise_area_w[2];     // for the double precision iteration shader
+        GLdouble precise_area_h[2];
+        GLdouble julia_parameter[2];    // unused by the tiles
+    };
+
+private:
+    using tile_texture = std::shared_ptr<const GLtexture>;
+
+    // answer of disk_thread to a read
+    struct LoadedTile
+    {
+        TileCoordinates tile;
+        std::string key;
+        bool found;
+        IterationBuffer buffer;
+    };
+
+    // tile whose rows are dispatched over several batches, because one tile costs more than the budget
+    struct PartialTile
+    {
+        TileCoordinates tile;
+        tile_texture texture;
+        int rows_done;          // from the bottom, in GL row order
+    };
+
+    PyramidPrograms programs;
+    std::string backend;
+    DiskCache* disk_cache;
+    GLframebuffer framebuffer;
+    GLbuffer view_buffer;
+    ViewParameters view_parameters{};
+    GLuint bound_program = 0;
+    ReadbackRing readbacks;     // computed tiles on their way to disk_thread
+
+    unsigned max_iterations = 0;
+    LruCache<std::string, tile_texture> tiles;
+    std::unique_ptr<PartialTile> partial;           // not in tiles until its last row is done
+
+    std::unordered_set<std::string> loading;        // keys disk_thread has not answered yet
+    std::unordered_set<std::string> disk_misses;    // keys known not to be on disk
+    std::mutex loaded_mutex;
+    std::vector<LoadedTile> loaded;                 // answered, shared with disk_thread
+    ThreadPool disk_thread{1};                      // reads and writes of the disk cache; last, so that it stops first
+
+    tile_texture find(const TileCoordinates& tile);
+    void bind_target(const GLtexture& texture) const;
+    // Skips the GL call when nothing changed.
+    void set_view_parameters(const ViewParameters& parameters);
+
+    // Queues the disk read; upload_loaded() turns the answers into tiles on a later frame.
+    void load_cached(const TileCoordinates& tile, const std::string& key);
+    void upload_loaded();
+    tile_texture downsample(const TileCoordinates& tile);
+    tile_texture compute(const TileCoordinates& tile);
+    // Runs the escape-time shader over rows [first_row, first_row + row_count) of the texture only.
+    void compute_rows(const TileCoordinates& tile, const GLtexture& texture, int first_row, int row_count);
+    // Dispatches the next band of rows of the nearest tile; returns it once every row is done.
+    tile_texture compute_partial(const TileCoordinates& tile, double fraction);
+    // Reads a computed tile back into the disk cache.
+    void store(const TileCoordinates& tile, const GLtexture& texture);
+
+public:
+    static constexpr int TILE_SIZE = 256;
+    static constexpr GLuint VIEW_BINDING = 0;
+
+    // capacity is the number of tile textures kept on the GPU. backend identifies the iteration
+    // shader in disk cache keys, so that tiles computed by another version are not reused.
+    TilePyramid(const PyramidPrograms& programs, const std::string& backend, DiskCache* disk_cache, std::size_t capacity);
+    TilePyramid(const TilePyramid&) = delete;
+    ~TilePyramid();
+
+    TilePyramid& operator=(const TilePyramid&) = delete;
+
+    // Tiles made by a replaced iteration or downsample program are dropped. Binds the vertex array.
+    void set_programs(const PyramidPrograms& programs, const std::string& backend);
+    const PyramidPrograms& get_programs() const noexcept {return programs;}
+
+    // Skips the GL call when the program is bound already; program and vertex array stay bound across
+    // frames, so other passes drawing in between switch programs through here as well.
+    void use_program(GLuint program);
+    // Bound at VIEW_BINDING; other passes with a view block of their own bind this one back after them.
+    const GLbuffer& get_view_buffer() const noexcept {return view_buffer;}
+
+    // Fills in the missing tiles of the level matching the viewport, nearest to the centre first.
+    // The ones left for the escape-time shader run together after the loads and downsamples, as one
+    // batch of the scheduler, so that its timing covers them alone; the rest wait for later frames.
+    // When one tile exceeds the budget, the nearest is computed a band of rows per batch instead.
+    void update(const Viewport& viewport, unsigned max_iterations, ComputeScheduler& scheduler);
+    void draw(const Viewport& viewport, const ColorOptions& options);
+};
+
+#endif
@@ -0,0 +1,274 @@
+#include "tile_server.hpp"
+#include "image.hpp"
+#include "trace.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <exception>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+
+namespace
+{
+    constexpr std::size_t MAX_REQUEST_SIZE = 8192;
+    // seconds a connection may block a pool thread in one send or receive; idle clients are dropped
+    constexpr unsigned CONNECTION_TIMEOUT = 10;
+    // accepted sockets queued or being handled, well below the usual limit of 1024 descriptors
+    constexpr unsigned MAX_OPEN_CONNECTIONS = 512;
+    // before accepting again after running out of descriptors anyway, e.g. to the disk cache
+    constexpr std::chrono::milliseconds ACCEPT_BACKOFF{100};
+
+    std::string read_request_head(const Socket& connection)
+    {
+        std::string request;
+        char buffer[1024];
+
+        while (request.find("\r\n\r\n") == std::string::npos)
+        {
+            if (request.size() > MAX_REQUEST_SIZE)
+                throw std::runtime_error{"request too large"};
+
+            const std::size_t received = ::receive_some(connection, buffer, sizeof(buffer));
+            if (!received)
+                throw std::runtime_error{"connection closed before end of request"};
+
+            request.append(buffer, received);
+        }
+
+        return request;
+    }
+
+    void send_response(const Socket& connection, const std::string& status,
+                       const std::string& content_type, const std::string& body)
+    {
+        std::ostringstream head;
+        head << "HTTP/1.1 " << status << "\r\n"
+             << "Content-Type: " << content_type << "\r\n"
+             << "Content-Length: " << body.size() << "\r\n"
+             << "Access-Control-Allow-Origin: *\r\n"
+             << "Connection: close\r\n\r\n";
+
+        const std::string response = head.str() + body;
+        ::send_all(connection, response.data(), response.size());
+    }
+
+    bool parse_unsigned(const std::string& text, std::uint64_t& value) noexcept
+    {
+        if (text.empty() || text.size() > 20)
+            return false;
+
+        value = 0;
+        for (const char c : text)
+        {
+            if (c < '0' || c > '9')
+                return false;
+            value = value * 10 + static_cast<std::uint64_t>(c - '0');
+        }
+        return true;
+    }
+
+    // "/z/x/y.png"
+    bool parse_tile_path(const std::string& path, TileCoordinates& tile) noexcept
+    {
+        const std::string suffix = ".png";
+        if (path.size() < suffix.size() + 6 || path[0] != '/' ||
+            path.compare(path.size() - suffix.size(), suffix.size(), suffix) != 0)
+            return false;
+
+        const std::string body = path.substr(1, path.size() - suffix.size() - 1);
+        const std::size_t first  = body.find('/');
+        const std::size_t second = first == std::string::npos ? first : body.find('/', first + 1);
+        if (second == std::string::npos)
+            return false;
+
+        std::uint64_t z;
+        if (!::parse_unsigned(body.substr(0, first), z) ||
+            !::parse_unsigned(body.substr(first + 1, second - first - 1), tile.x) ||
+            !::parse_unsigned(body.substr(second + 1), tile.y) || z > MAX_TILE_LEVEL)
+            return false;
+
+        tile.z = static_cast<unsigned>(z);
+        return ::valid_tile(tile);
+    }
+}
+
+TileServer::TileServer(const TileServerSettings& settings, DiskCache* disk_cache) :
+    settings{settings}, disk_cache{disk_cache}, listener{::listen_socket(settings.port)}, cache{settings.cache_tiles},
+    pool{settings.thread_count}
+{
+    if (settings.tile_size <= 0 || settings.tile_size > 4096)
+        throw std::runtime_error{"tile size must be between 1 and 4096"};
+}
+
+TileServer::tile_data TileServer::render_tile(const TileCoordinates& tile) const
+{
+    const TraceScope trace{"render_tile"};
+
+    const Viewport viewport{::tile_viewport(tile, settings.tile_size)};
+    const bool mandelbrot = settings.formula == Formula::mandelbrot;
+    const Precision precision = mandelbrot ? ::tile_precision(tile, settings.tile_size) : Precision::fp64;
+
+    // the disk cache holds iteration counts only, so these are always rendered
+    if (settings.distance_estimation && mandelbrot && precision != Precision::perturbation)
+    {
+        const DistanceEstimate estimate{::render_distance_estimate(viewport, settings.max_iterations, precision, 1)};
+        return std::make_shared<const std::string>(
+                    ::encode_png(estimate.buffer.width, estimate.buffer.height,
+                                 ::colorize_distance(estimate, settings.max_iterations)));
+    }
+
+    const std::string backend{mandelbrot ? "cpu" : std::string{"cpu-"} + ::formula_name(settings.formula)};
+    const std::string key{DiskCache::key(DiskCache::viewport_bounds(viewport, backend), settings.max_iterations, precision)};
+
+    IterationBuffer buffer;
+    if (!disk_cache || !disk_cache->load(key, buffer))
+    {
+        buffer = ::render_iterations(viewport, settings.max_iterations, precision, 1, settings.formula);
+        if (disk_cache)
+            disk_cache->store(key, buffer);
+    }
+
+    return std::make_shared<const std::string>(
+                ::encode_png(buffer.width, buffer.height, ::colorize(buffer, settings.max_iterations)));
+}
+
+TileServer::tile_data TileServer::find_or_render(const TileCoordinates& tile)
+{
+    const std::string key{::tile_name(tile)};
+
+    std::promise<tile_data> promise;
+    std::shared_future<tile_data> pending;
+    {
+        const std::lock_guard<std::mutex> lock{mutex};
+
+        tile_data data;
+        if (cache.get(key, data))
+        {
+            ++cache_hits;
+            return data;
+        }
+
+        const auto found = in_flight.find(key);
+        if (found == in_flight.end())
+            in_flight.emplace(key, promise.get_future().share());
+        else
+        {
+            ++coalesced;
+            pending = found->second;
+        }
+    }
+
+    if (pending.valid())
+        return pending.get();
+
+    tile_data data;
+    try
+    {
+        data = render_tile(tile);
+        ++rendered;
+    }
+    catch (...)
+    {
+        {
+            const std::lock_guard<std::mutex> lock{mutex};
+            in_flight.erase(key);
+        }
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+
+    {
+        const std::lock_guard<std::mutex> lock{mutex};
+        cache.put(key, data);
+        in_flight.erase(key);
+    }
+    promise.set_value(data);
+
+    return data;
+}
+
+std::string TileServer::stats_json() const
+{
+    std::ostringstream json;
+    json << "{\"requests\":" << requests << ",\"cache_hits\":" << cache_hits
+         << ",\"coalesced\":" << coalesced << ",\"rendered\":" << rendered << "}\n";
+    return json.str();
+}
+
+void TileServer::handle_connection(const Socket& connection)
+{
+    const TraceScope trace{"handle_connection"};
+
+    const std::string request{::read_request_head(connection)};
+    ++requests;
+
+    std::istringstream request_line{request.substr(0, request.find("\r\n"))};
+    std::string method, path;
+    request_line >> method >> path;
+
+    if (method != "GET")
+        return ::send_response(connection, "405 Method Not Allowed", "text/plain", "only GET is supported\n");
+
+    if (path == "/stats")
+        return ::send_response(connection, "200 OK", "application/json", stats_json());
+
+    TileCoordinates tile;
+    if (!::parse_tile_path(path, tile))
+        return ::send_response(connection, "404 Not Found", "text/plain", "expected /z/x/y.png\n");
+
+    try
+    {
+        ::send_response(connection, "200 OK", "image/png", *find_or_render(tile));
+    }
+    catch (const std::exception& ex)
+    {
+        ::send_response(connection, "500 Internal Server Error", "text/plain", std::string{ex.what()} + '\n');
+    }
+}
+
+void TileServer::run()
+{
+    std::cerr << "serving tiles on http://127.0.0.1:" << settings.port << "/{z}/{x}/{y}.png with "
+              << pool.size() << " threads" << std::endl;
+
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock{connection_mutex};
+            connection_closed.wait(lock, [this] {return open_connections < MAX_OPEN_CONNECTIONS;});
+        }
+
+        // only a broken listener throws, and ends the server
+        Socket accepted{::accept_connection(listener)};
+        if (accepted < 0)
+        {
+            std::cerr << "accept: " << std::strerror(errno) << ", retrying" << std::endl;
+            std::this_thread::sleep_for(ACCEPT_BACKOFF);
+            continue;
+        }
+
+        {
+            const std::lock_guard<std::mutex> lock{connection_mutex};
+            ++open_connections;
+        }
+
+        // the slot is freed when the descriptor is closed, after the last task holding it
+        const std::shared_ptr<Socket> connection{new Socket{std::move(accepted)}, [this](Socket* socket)
+                                                 {
+                                                     delete socket;
+                                                     {
+                                                         const std::lock_guard<std::mutex> lock{connection_mutex};
+                                                         --open_connections;
+                                                     }
+                                                     connection_closed.notify_one();
+                                                 }};
+        pool.submit([this, connection]
+                    {
+                        ::set_timeouts(*connection, CONNECTION_TIMEOUT);
+                        handle_connection(*connection);
+                    });
+    }
+}
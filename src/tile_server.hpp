@@ -0,0 +1,69 @@
+#ifndef TILE_SERVER_HPP
+#define TILE_SERVER_HPP
+
+#include "tiles.hpp"
+#include "disk_cache.hpp"
+#include "thread_pool.hpp"
+#include "lru_cache.hpp"
+#include "socket.hpp"
+
+#include <string>
+#include <memory>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <unordered_map>
+
+struct TileServerSettings
+{
+    unsigned short port;
+    unsigned thread_count;
+    unsigned max_iterations;
+    int tile_size;
+    std::size_t cache_tiles;
+    bool distance_estimation;   // tiles shallow enough for fp64 darken towards the boundary
+    Formula formula;            // other than mandelbrot, tiles stop deepening where fp64 runs out
+};
+
+// HTTP/1.1 server on localhost answering GET /z/x/y.png with rendered tiles and GET /stats with
+// counters as JSON. Connections are handled on a thread pool; concurrent requests for the same tile
+// wait for a single render instead of starting their own. Iteration buffers are looked up in the
+// optional disk cache before rendering. Only so many connections are accepted at a time, so that
+// a burst of clients waits in the listen backlog instead of exhausting file descriptors.
+class TileServer
+{
+    using tile_data = std::shared_ptr<const std::string>;
+
+    TileServerSettings settings;
+    DiskCache* disk_cache;
+    Socket listener;
+
+    std::mutex mutex;
+    LruCache<std::string, tile_data> cache;
+    std::unordered_map<std::string, std::shared_future<tile_data>> in_flight;
+
+    std::atomic<unsigned long> requests{0};
+    std::atomic<unsigned long> cache_hits{0};
+    std::atomic<unsigned long> coalesced{0};
+    std::atomic<unsigned long> rendered{0};
+
+    // accepted sockets, queued or being handled, at most MAX_OPEN_CONNECTIONS
+    std::mutex connection_mutex;
+    std::condition_variable connection_closed;
+    unsigned open_connections = 0;
+
+    ThreadPool pool;
+
+    tile_data render_tile(const TileCoordinates& tile) const;
+    tile_data find_or_render(const TileCoordinates& tile);
+    std::string stats_json() const;
+    void handle_connection(const Socket& connection);
+
+public:
+    TileServer(const TileServerSettings& settings, DiskCache* disk_cache);
+
+    void run();
+};
+
+#endif
@@ -0,0 +1,79 @@
+#include "tiles.hpp"
+
+#include <stdexcept>
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+    constexpr double TILE_ORIGIN_X = -2.75;
+    constexpr double TILE_ORIGIN_Y =  2.0;
+    constexpr double TILE_EXTENT   =  4.0;
+
+    HighPrecision tile_offset(std::uint64_t position, unsigned z)
+    {
+        // (position + 0.5) * extent / 2^z, built from exact powers of two
+        HighPrecision offset;
+        const HighPrecision step = HighPrecision::from_double(std::ldexp(TILE_EXTENT, -static_cast<int>(z)));
+        for (unsigned bit = 64; bit-- > 0;)
+        {
+            offset = offset + offset;
+            if (position & (1ULL << bit))
+                offset = offset + step;
+        }
+        return offset + HighPrecision::from_double(std::ldexp(TILE_EXTENT, -static_cast<int>(z) - 1));
+    }
+}
+
+bool valid_tile(const TileCoordinates& tile) noexcept
+{
+    return tile.z <= MAX_TILE_LEVEL && tile.x < (1ULL << tile.z) && tile.y < (1ULL << tile.z);
+}
+
+Viewport tile_viewport(const TileCoordinates& tile, int tile_size)
+{
+    if (!valid_tile(tile))
+        throw std::runtime_error{"invalid tile " + ::tile_name(tile)};
+
+    return {HighPrecision::from_double(TILE_ORIGIN_X) + ::tile_offset(tile.x, tile.z),
+            HighPrecision::from_double(TILE_ORIGIN_Y) - ::tile_offset(tile.y, tile.z),
+            std::ldexp(TILE_EXTENT, -static_cast<int>(tile.z)) / tile_size, tile_size, tile_size};
+}
+
+Precision tile_precision(const TileCoordinates& tile, int tile_size) noexcept
+{
+    return ::default_precision(std::ldexp(TILE_EXTENT, -static_cast<int>(tile.z)) / tile_size);
+}
+
+unsigned tile_level(double pixel_size, int tile_size) noexcept
+{
+    const double level = std::ceil(std::log2(TILE_EXTENT / (tile_size * pixel_size)));
+    return level <= 0.0 ? 0 : level >= MAX_TILE_LEVEL ? MAX_TILE_LEVEL : static_cast<unsigned>(level);
+}
+
+TileRange visible_tiles(const Viewport& viewport, unsigned z) noexcept
+{
+    const double tile_extent = std::ldexp(TILE_EXTENT, -static_cast<int>(z));
+    const double last = std::ldexp(1.0, static_cast<int>(z)) - 1.0;
+
+    const double center_x = viewport.center_x.to_double();
+    const double center_y = viewport.center_y.to_double();
+    const double half_w = 0.5 * viewport.width  * viewport.pixel_size;
+    const double half_h = 0.5 * viewport.height * viewport.pixel_size;
+
+    const double x0 = std::floor((center_x - half_w - TILE_ORIGIN_X) / tile_extent);
+    const double x1 = std::floor((center_x + half_w - TILE_ORIGIN_X) / tile_extent);
+    const double y0 = std::floor((TILE_ORIGIN_Y - center_y - half_h) / tile_extent);
+    const double y1 = std::floor((TILE_ORIGIN_Y - center_y + half_h) / tile_extent);
+
+    if (x1 < 0.0 || y1 < 0.0 || x0 > last || y0 > last)
+        return {z, 1, 1, 0, 0};
+
+    return {z, static_cast<std::uint64_t>(std::max(x0, 0.0)), static_cast<std::uint64_t>(std::max(y0, 0.0)),
+               static_cast<std::uint64_t>(std::min(x1, last)), static_cast<std::uint64_t>(std::min(y1, last))};
+}
+
+std::string tile_name(const TileCoordinates& tile)
+{
+    return std::to_string(tile.z) + '/' + std::to_string(tile.x) + '/' + std::to_string(tile.y);
+}
@@ -0,0 +1,49 @@
+#ifndef TILES_HPP
+#define TILES_HPP
+
+#include "kernel.hpp"
+
+#include <string>
+#include <cstdint>
+
+// Slippy-map tile addressing: level 0 is one tile covering [-2.75, 1.25] x [-2, 2], each level
+// splits every tile into four, x grows to the right and y grows downwards.
+struct TileCoordinates
+{
+    unsigned z;
+    std::uint64_t x;
+    std::uint64_t y;
+};
+
+inline bool operator==(const TileCoordinates& a, const TileCoordinates& b) noexcept
+{
+    return a.z == b.z && a.x == b.x && a.y == b.y;
+}
+
+inline bool operator!=(const TileCoordinates& a, const TileCoordinates& b) noexcept {return !(a == b);}
+
+// Inclusive range of tiles on one level.
+struct TileRange
+{
+    unsigned z;
+    std::uint64_t x0;
+    std::uint64_t y0;
+    std::uint64_t x1;
+    std::uint64_t y1;
+};
+
+constexpr unsigned MAX_TILE_LEVEL = 63;
+
+bool valid_tile(const TileCoordinates& tile) noexcept;
+Viewport tile_viewport(const TileCoordinates& tile, int tile_size);
+
+Precision tile_precision(const TileCoordinates& tile, int tile_size) noexcept;
+
+// Coarsest level whose tile pixels are no larger than pixel_size.
+unsigned tile_level(double pixel_size, int tile_size) noexcept;
+// Tiles of level z overlapping the viewport; empty (x0 > x1) when it lies outside level 0.
+TileRange visible_tiles(const Viewport& viewport, unsigned z) noexcept;
+
+std::string tile_name(const TileCoordinates& tile);
+
+#endif
@@ -0,0 +1,138 @@
+#include "trace.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+
+std::atomic<bool> trace_enabled{false};
+
+namespace
+{
+    constexpr std::size_t MAX_THREAD_EVENTS = std::size_t{1} << 20;
+
+    struct TraceEvent
+    {
+        const char* name;
+        std::int64_t start;     // nanoseconds
+        std::int64_t duration;
+    };
+
+    // Each thread appends to its own buffer; the lock is only ever contended by write_trace().
+    struct ThreadBuffer
+    {
+        unsigned thread_id;
+        std::mutex mutex;
+        std::vector<TraceEvent> events;
+        std::size_t dropped = 0;
+    };
+
+    std::mutex registry_mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> registry;
+    unsigned next_thread_id = 1;
+
+    ThreadBuffer& thread_buffer()
+    {
+        thread_local const std::shared_ptr<ThreadBuffer> buffer = []
+        {
+            const auto created = std::make_shared<ThreadBuffer>();
+
+            const std::lock_guard<std::mutex> lock{registry_mutex};
+            created->thread_id = next_thread_id++;
+            registry.push_back(created);
+
+            return created;
+        }();
+
+        return *buffer;
+    }
+}
+
+void set_tracing(bool enabled) noexcept
+{
+    trace_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+std::int64_t trace_clock() noexcept
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void record_trace_event(const char* name, std::int64_t start) noexcept
+{
+    const std::int64_t end = ::trace_clock();
+
+    try
+    {
+        ThreadBuffer& buffer = ::thread_buffer();
+
+        const std::lock_guard<std::mutex> lock{buffer.mutex};
+        if (buffer.events.size() < MAX_THREAD_EVENTS)
+            buffer.events.push_back({name, start, end - start});
+        else
+            ++buffer.dropped;
+    }
+    catch (const std::exception&)
+    {
+        // out of memory: the event is lost, the traced code carries on
+    }
+}
+
+bool write_trace(const std::string& file_path)
+{
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        const std::lock_guard<std::mutex> lock{registry_mutex};
+        buffers = registry;
+
+        // buffers of finished threads are only referenced by the registry and this copy
+        registry.erase(std::remove_if(registry.begin(), registry.end(),
+                                      [](const std::shared_ptr<ThreadBuffer>& buffer) {return buffer.use_count() == 2;}),
+                       registry.end());
+    }
+
+    std::ofstream stream{file_path, std::ios::out};
+    stream << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    const char* separator = "\n";
+    std::size_t count = 0, dropped = 0;
+    for (const auto& buffer : buffers)
+    {
+        std::vector<TraceEvent> events;
+        {
+            const std::lock_guard<std::mutex> lock{buffer->mutex};
+            events.swap(buffer->events);
+            dropped += buffer->dropped;
+            buffer->dropped = 0;
+        }
+
+        for (const TraceEvent& event : events)
+        {
+            stream << separator << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->thread_id
+                   << ",\"ts\":" << event.start * 1e-3 << ",\"dur\":" << event.duration * 1e-3 << '}';
+            separator = ",\n";
+        }
+        count += events.size();
+    }
+
+    stream << "\n]}\n";
+    stream.close();
+
+    if (!stream)
+    {
+        std::cerr << "cannot write trace " << file_path << std::endl;
+        return false;
+    }
+
+    std::cerr << "trace: " << count << " events written to " << file_path;
+    if (dropped)
+        std::cerr << ", " << dropped << " dropped";
+    std::cerr << std::endl;
+
+    return true;
+}
@@ -0,0 +1,40 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <string>
+#include <atomic>
+#include <cstdint>
+
+// Timeline of named scopes per thread, exported in the Chrome trace event format that
+// chrome://tracing and ui.perfetto.dev load. While tracing is off a scope costs one relaxed load.
+
+extern std::atomic<bool> trace_enabled;
+
+inline bool tracing() noexcept {return trace_enabled.load(std::memory_order_relaxed);}
+
+void set_tracing(bool enabled) noexcept;
+std::int64_t trace_clock() noexcept;
+// name must outlive the trace, e.g. a string literal.
+void record_trace_event(const char* name, std::int64_t start) noexcept;
+
+// Writes every event recorded so far and forgets them. Failures are reported on stderr.
+bool write_trace(const std::string& file_path);
+
+class TraceScope
+{
+    const char* name;
+    std::int64_t start;
+
+public:
+    explicit TraceScope(const char* name) noexcept : name{name}, start{::tracing() ? ::trace_clock() : -1} {}
+    TraceScope(const TraceScope&) = delete;
+    ~TraceScope()
+    {
+        if (start >= 0)
+            ::record_trace_event(name, start);
+    }
+
+    TraceScope& operator=(const TraceScope&) = delete;
+};
+
+#endif
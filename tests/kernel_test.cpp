@@ -0,0 +1,58 @@
+#include "kernel.hpp"
+
+#include <iostream>
+#include <cstdlib>
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char* description)
+    {
+        if (!condition)
+        {
+            std::cerr << "FAILED: " << description << '\n';
+            ++failures;
+        }
+    }
+
+    Viewport viewport_at(double center_x, double center_y, double pixel_size, int width, int height)
+    {
+        return {HighPrecision::from_double(center_x), HighPrecision::from_double(center_y), pixel_size, width, height};
+    }
+
+    // The period-3 minibrot on the real axis lies off the main cardioid and the period-2 bulb, so no
+    // interior shortcut covers it: its pixels never escape and must be sampled once.
+    void minibrot_interior_is_sampled_once()
+    {
+        const DistanceEstimate estimate{::render_distance_estimate(
+            viewport_at(-1.7548776662466927, 0.0, 1e-6, 4, 4), 1000, Precision::fp64, 1)};
+
+        for (float distance : estimate.distances)
+            check(distance == 0.0F, "minibrot interior has distance 0");
+        for (std::uint32_t iteration : estimate.buffer.iterations)
+            check(iteration == 1000, "minibrot interior runs every iteration");
+        check(estimate.supersampled == 0, "minibrot interior is not supersampled");
+    }
+
+    void boundary_is_supersampled()
+    {
+        const DistanceEstimate estimate{::render_distance_estimate(
+            viewport_at(-0.75, 0.0, 3.0 / 64, 64, 64), 200, Precision::fp64, 1)};
+
+        check(estimate.supersampled > 0, "pixels next to the boundary are supersampled");
+        check(estimate.supersampled < estimate.distances.size(), "not every pixel is supersampled");
+    }
+}
+
+int main()
+{
+    ::minibrot_interior_is_sampled_once();
+    ::boundary_is_supersampled();
+
+    if (failures != 0)
+        return EXIT_FAILURE;
+
+    std::cout << "kernel tests passed\n";
+    return EXIT_SUCCESS;
+}